@@ -252,6 +252,11 @@ MK := mkimage
 # Represents an empty white space - we need it for extracting the elf entry address from readelf output
 SPACE := $() $()
 
+# Fails if a function in a .text.int_only section (IRQ_INT_ONLY() in irq_c5soc.h) uses a VFP or NEON instruction.
+# Their interrupts are dispatched without saving the VFP registers.  The CMSIS GIC functions the dispatcher calls
+# are checked too, and reading FPEXC is allowed as it doesn't touch the registers
+CHECK_INT_ONLY = $(OD) -d $(1) | awk '/^Disassembly of section/ { s = ($$4 ~ /^\.text\.(int_only\.|IRQ_GetActiveIRQ:|IRQ_EndOfInterrupt:)/) } s && $$3 ~ /^(v|fld|fst|fmrx|fmxr|fmstat)/ && $$0 !~ /fpexc/ { print "Error: VFP/NEON instruction in integer only code: " $$0; bad = 1 } END { exit bad }'
+
 # ===========
 # Build rules
 # ===========
@@ -376,6 +381,7 @@ $(DBG_PATH)/%.o: $(DBG_SRCS_PRE)
 	
 # Link object files
 $(DBG_ELF): $(DBG_OBJS)
+	@$(call CHECK_INT_ONLY,$(DBG_OBJS))
 	$(LD) $(DBG_LDFLAGS) $(DBG_OBJS) -o $@
 	$(NM) $@ > $@.map
 	$(OD) -d $@ > $@.objdump
@@ -415,6 +421,7 @@ $(REL_PATH)/%.o: $(REL_SRCS_PRE)
 
 # Link object files
 $(REL_ELF): $(REL_OBJS)
+	@$(call CHECK_INT_ONLY,$(REL_OBJS))
 	$(LD) $(REL_LDFLAGS) $(REL_OBJS) -o $@
 	$(NM) $@ > $@.map
 	$(OD) -d $@ > $@.objdump
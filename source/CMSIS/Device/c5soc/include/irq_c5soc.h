@@ -24,6 +24,7 @@
 #define IRQ_C5SOC_H
 
 #include <stdint.h>
+#include "tru_config.h"
 
 #define IRQ_GIC_LINE_COUNT 256U
 #define IRQ_GIC_EXTERN_IRQ_TABLE
@@ -330,5 +331,45 @@ typedef void (*IRQHandler_t) (void);
 
 void irq_set_group_priority(IRQn_ID_t irqn, uint8_t grp_priority, uint8_t sub_priority);
 void irq_mask(uint8_t mask);
+void irq_set_vfp(IRQn_ID_t irqn, uint8_t vfp);
+void irq_route_fiq(IRQn_ID_t irqn);
+uint32_t irq_get_fiq_in_irq(void);
+
+// Puts an integer only function, see irq_set_vfp(), in its own .text.int_only
+// section.  The build disassembles the objects and fails if one of these uses
+// a VFP or NEON instruction.  Mark the handler and each function it calls
+#define IRQ_INT_ONLY(name) __attribute__((section(".text.int_only." #name)))
+
+#if(TRU_IRQ_STATS == 1U)
+// Per interrupt statistics kept by IRQ_Handler and FIQ_Handler, in global
+// timer ticks.
+//
+// The dispatch time is from the first C statement of the dispatcher to the
+// handler call, mostly the GICC_IAR read.  It is not the latency from the
+// GIC pending the interrupt, which software can't see in general.  That
+// latency is only recorded for an interrupt whose assert time is known and
+// given to irq_stats_set_assert() before it fires, e.g. a global timer
+// compare, otherwise latency_count stays 0.
+typedef struct{
+	uint64_t total_ticks;           // Handler time
+	uint64_t dispatch_total_ticks;
+	uint64_t latency_total_ticks;   // Assert to handler call
+	uint32_t count;
+	uint32_t min_ticks;
+	uint32_t max_ticks;
+	uint32_t dispatch_min_ticks;
+	uint32_t dispatch_max_ticks;
+	uint32_t latency_count;
+	uint32_t latency_min_ticks;
+	uint32_t latency_max_ticks;
+	uint32_t assert_ticks;          // Global timer low word of the next assert
+	uint32_t assert_armed;          // 1 = assert_ticks is for the next run
+}__attribute__((aligned(32))) irq_stats_t;
+
+void irq_stats_set_assert(IRQn_ID_t irqn, uint32_t assert_ticks);
+void irq_stats_get(IRQn_ID_t irqn, irq_stats_t *stats);
+void irq_stats_reset(void);
+void irq_stats_dump(uint32_t tick_hz);
+#endif
 
 #endif
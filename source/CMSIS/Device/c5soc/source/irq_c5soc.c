@@ -23,10 +23,29 @@
 #include "irq_c5soc.h"
 #include "c5soc.h"
 #include <stddef.h>
+#if(TRU_IRQ_STATS == 1U)
+	#include "tru_cortex_a9.h"
+	#include <stdio.h>
+#endif
 
 // Define CMSIS IRQ handler table (see irq_ctrl_gic.h)
 IRQHandler_t IRQTable[IRQ_GIC_LINE_COUNT] = { 0U };
 
+// One bit per IRQ, set = the handler is integer only and IRQ_Handler does not
+// save the VFP registers for it (see irq_set_vfp())
+static uint32_t irq_int_only[IRQ_GIC_LINE_COUNT / 32U];
+
+// The interrupt made the FIQ by irq_route_fiq(), and the times IRQ_Handler
+// acknowledged it instead (see irq_route_fiq())
+static IRQn_ID_t irq_fiq_id = -1;
+static volatile uint32_t irq_fiq_in_irq;
+
+#if(TRU_IRQ_STATS == 1U)
+// Per interrupt timing, one cache line or two each so that updating one
+// entry doesn't evict its neighbours
+static irq_stats_t irq_stats[IRQ_GIC_LINE_COUNT];
+#endif
+
 // Overrride CMSIS default weak prototype (see irq_ctrl_gic.h)
 int32_t IRQ_Initialize(void){
 	uint32_t i;
@@ -34,6 +53,9 @@ int32_t IRQ_Initialize(void){
 	for (i = 0U; i < IRQ_GIC_LINE_COUNT; i++) {
 		IRQTable[i] = (IRQHandler_t)NULL;
 	}
+	for (i = 0U; i < IRQ_GIC_LINE_COUNT / 32U; i++) {
+		irq_int_only[i] = 0U;
+	}
 	GIC_Enable();
 
 	return (0U);
@@ -46,42 +68,225 @@ int32_t IRQ_Initialize(void){
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wattributes"
 
-// Overrride CMSIS default weak prototype (see irq_ctrl_gic.h)
-void __attribute__((interrupt("IRQ"))) IRQ_Handler(void){
-	// Save floating point registers (VFP registers)
 #if((__FPU_PRESENT == 1) && (__FPU_USED == 1))
+// Calls a handler with the floating point registers (VFP registers) saved
+// around it, 264 bytes of stack.  The handler's own code does not touch them
+static void __attribute__((naked, noinline)) irq_call_vfp(IRQHandler_t handler){
 	__ASM volatile(
-		"SUB    sp, sp, #4      \n"  // Correct SP early by pushing a dummy, which will make it even for the r0 push below (number of pushes must be even)
-		"VMRS   r0, fpscr       \n"  // Read FP status value
-		"STMFD  sp!, {r0}       \n"  // Push FP status value onto the stack
+		"PUSH   {r4, lr}        \n"  // r4 keeps the FP status across the call, two pushes keep SP 8 byte aligned
+		"VMRS   r4, fpscr       \n"  // Read FP status value
 		"VSTMDB sp!, {d0-d15}   \n"  // Push d0-d15 VFP registers
 		"VSTMDB sp!, {d16-d31}  \n"  // Push d16-d31 VFP registers
+		"BLX    r0              \n"  // Call the handler
+		"VLDMIA sp!, {d16-d31}  \n"  // Pop into d16-d31 registers
+		"VLDMIA sp!, {d0-d15}   \n"  // Pop into d0-d15 registers
+		"VMSR   fpscr, r4       \n"  // Restore FP status value
+		"POP    {r4, pc}        \n"  // Return
 	);
+}
+#endif
+
+// Calls the user registered handler of an IRQ.  It and the dispatchers below
+// run before the VFP save, so they are all marked integer only
+static inline void IRQ_INT_ONLY(irq_call) irq_call(IRQn_ID_t irq_id){
+#if((__FPU_PRESENT == 1) && (__FPU_USED == 1))
+	// Save the VFP registers only for handlers that may use them, and only
+	// while the VFP is enabled (FPEXC.EN), else there is nothing to save
+	if((irq_int_only[irq_id >> 5] & (1U << (irq_id & 0x1fU))) == 0U && (__get_FPEXC() & 0x40000000U)){
+		irq_call_vfp(IRQTable[irq_id]);
+	}else{
+		IRQTable[irq_id]();
+	}
+#else
+	IRQTable[irq_id]();
+#endif
+}
+
+#if(TRU_IRQ_STATS == 1U)
+// Calls the handler and adds the run to its statistics.  entry is the global
+// timer low word at the start of the dispatcher, the low word is enough for
+// the differences
+static inline void IRQ_INT_ONLY(irq_call_stats) irq_call_stats(IRQn_ID_t irq_id, uint32_t entry){
+	irq_stats_t *st = &irq_stats[irq_id];
+	uint32_t start = GTIM_REG->counterl;
+	uint32_t disp = start - entry;
+	uint32_t t;
+
+	if(st->assert_armed){
+		st->assert_armed = 0U;
+		t = start - st->assert_ticks;
+		if(st->latency_count == 0U || t < st->latency_min_ticks) st->latency_min_ticks = t;
+		if(t > st->latency_max_ticks) st->latency_max_ticks = t;
+		st->latency_total_ticks += t;
+		st->latency_count++;
+	}
+
+	irq_call(irq_id);
+	t = GTIM_REG->counterl - start;
+
+	if(st->count == 0U || t < st->min_ticks) st->min_ticks = t;
+	if(t > st->max_ticks) st->max_ticks = t;
+	if(st->count == 0U || disp < st->dispatch_min_ticks) st->dispatch_min_ticks = disp;
+	if(disp > st->dispatch_max_ticks) st->dispatch_max_ticks = disp;
+	st->total_ticks += t;
+	st->dispatch_total_ticks += disp;
+	st->count++;
+}
 #endif
 
+#if(TRU_IRQ_NESTED == 1U)
+// Called from IRQ_Handler in SYS mode with IRQs masked.  The handler runs with
+// IRQs enabled, and the GIC only signals a higher group-priority than the one
+// active (see irq_c5soc.h).  Data a handler shares with a higher priority one
+// needs IRQs masked around its updates
+void __attribute__((used)) IRQ_INT_ONLY(irq_dispatch_nested) irq_dispatch_nested(void){
+#if(TRU_IRQ_STATS == 1U)
+	uint32_t entry = GTIM_REG->counterl;
+#endif
 	IRQn_ID_t irq_id = IRQ_GetActiveIRQ();  // Get ID of the triggered interrupt
 
 	if((irq_id >= 0U) && (irq_id < (IRQn_ID_t)IRQ_GIC_LINE_COUNT)){
-		IRQTable[irq_id]();  // Call the user registered IRQ handler
+		if(irq_id == irq_fiq_id) irq_fiq_in_irq++;
+		__enable_irq();   // Allow higher priority interrupts
+#if(TRU_IRQ_STATS == 1U)
+		irq_call_stats(irq_id, entry);  // Call the user registered IRQ handler
+#else
+		irq_call(irq_id);  // Call the user registered IRQ handler
+#endif
+		__disable_irq();
 	}
 
-	int32_t status = IRQ_EndOfInterrupt(irq_id);  // Set interrupt is serviced
+	IRQ_EndOfInterrupt(irq_id);  // Set interrupt is serviced, with IRQs masked again
+}
 
-	// Restore floating point registers (VFP registers)
-#if((__FPU_PRESENT == 1) && (__FPU_USED == 1))
+// Overrride CMSIS default weak prototype (see irq_ctrl_gic.h).  Handlers run
+// in SYS mode on the application stack, in IRQ mode a nested interrupt would
+// overwrite LR_irq
+void __attribute__((naked)) IRQ_INT_ONLY(IRQ_Handler) IRQ_Handler(void){
 	__ASM volatile(
-		"VLDMIA sp!, {d16-d31}  \n"  // Pop into d16-d31 registers
-		"VLDMIA sp!, {d0-d15}   \n"  // Pop into d0-d15 registers
-		"LDMFD  sp!, {r0}       \n"  // Pop into temporary r0 register
-		"VMSR   fpscr, r0       \n"  // Copy r0 to fpscr register
-		"ADD    sp, sp, #4      \n"  // Pop the dummy we pushed earlier
+		"SUB    lr, lr, #4              \n"  // Return address of the interrupted code
+		"SRSDB  sp!, #0x1f              \n"  // Push it and SPSR onto the SYS mode stack
+		"CPS    #0x1f                   \n"  // Switch to SYS mode, IRQs stay masked
+		"PUSH   {r0-r3, r12}            \n"  // Push the registers a C function may change
+		"AND    r1, sp, #4              \n"  // Align SP to 8 bytes for the C code
+		"SUB    sp, sp, r1              \n"
+		"PUSH   {r1, lr}                \n"  // Push the alignment and the interrupted code's LR
+		"BL     irq_dispatch_nested     \n"
+		"POP    {r1, lr}                \n"
+		"ADD    sp, sp, r1              \n"  // Undo the alignment
+		"POP    {r0-r3, r12}            \n"
+		"RFEIA  sp!                     \n"  // Pop the return address and CPSR, back to the interrupted code
 	);
+}
+#else
+// Overrride CMSIS default weak prototype (see irq_ctrl_gic.h)
+void __attribute__((interrupt("IRQ"))) IRQ_INT_ONLY(IRQ_Handler) IRQ_Handler(void){
+#if(TRU_IRQ_STATS == 1U)
+	uint32_t entry = GTIM_REG->counterl;
+#endif
+	IRQn_ID_t irq_id = IRQ_GetActiveIRQ();  // Get ID of the triggered interrupt
+
+	if((irq_id >= 0U) && (irq_id < (IRQn_ID_t)IRQ_GIC_LINE_COUNT)){
+		if(irq_id == irq_fiq_id) irq_fiq_in_irq++;
+#if(TRU_IRQ_STATS == 1U)
+		irq_call_stats(irq_id, entry);  // Call the user registered IRQ handler
+#else
+		irq_call(irq_id);  // Call the user registered IRQ handler
+#endif
+	}
+
+	IRQ_EndOfInterrupt(irq_id);  // Set interrupt is serviced
+}
+#endif
+
+// Overrride CMSIS default weak prototype (see irq_ctrl_gic.h)
+IRQn_ID_t IRQ_INT_ONLY(IRQ_GetActiveFIQ) IRQ_GetActiveFIQ(void){
+	IRQn_ID_t irqn = (IRQn_ID_t)GIC_AcknowledgePending();
+
+	__DSB();
+	return irqn;
+}
+
+// Overrride the startup weak alias.  Runs on the FIQ mode stack with IRQs and
+// FIQs masked, and preempts IRQ handlers, see irq_route_fiq()
+void __attribute__((interrupt("FIQ"))) IRQ_INT_ONLY(FIQ_Handler) FIQ_Handler(void){
+#if(TRU_IRQ_STATS == 1U)
+	uint32_t entry = GTIM_REG->counterl;
 #endif
+	IRQn_ID_t fiq_id = IRQ_GetActiveFIQ();  // Get ID of the triggered interrupt
+
+	if((fiq_id >= 0U) && (fiq_id < (IRQn_ID_t)IRQ_GIC_LINE_COUNT)){
+#if(TRU_IRQ_STATS == 1U)
+		irq_call_stats(fiq_id, entry);  // Call the user registered handler
+#else
+		irq_call(fiq_id);  // Call the user registered handler
+#endif
+	}
+
+	IRQ_EndOfInterrupt(fiq_id);  // Set interrupt is serviced
 }
 
 #pragma GCC diagnostic pop
 #endif
 
+/*
+    Makes an interrupt the FIQ.  It stays in group 0, which the GIC then
+    signals as FIQ, and all other interrupts move to group 1, signalled as
+    IRQ.  The handler is registered with IRQ_SetHandler() as usual.
+    The CPU must be in the secure state, as it is when started by U-Boot on
+    the Cyclone V.  The GIC hands out the highest priority pending interrupt
+    of either group, so give the FIQ a higher priority than the IRQs.
+
+    IRQ_Handler acknowledges the group 1 interrupts from the secure state
+    through GICC_IAR, which needs AckCtl set: the Cortex-A9 GIC (v1) has no
+    GICC_AIAR alias for them.  This leaves a race.  If the FIQ interrupt
+    becomes pending after an IRQ exception is taken but before IRQ_Handler
+    reads GICC_IAR, the read acknowledges it, and its handler runs once from
+    IRQ_Handler instead of FIQ_Handler, with the IRQ latency.
+    irq_get_fiq_in_irq() counts these.
+*/
+void irq_route_fiq(IRQn_ID_t irqn){
+	uint32_t n = (GIC_DistributorInfo() & 0x1fU) + 1U;  // Number of IGROUPR registers
+
+	for(uint32_t i = 0U; i < n; i++){
+		GICDistributor->IGROUPR[i] = 0xffffffffU;
+	}
+	GIC_SetGroup((IRQn_Type)irqn, 0U);
+	irq_fiq_id = irqn;
+
+	GICDistributor->CTLR |= 0x3U;  // Enable group 0 and group 1
+	GICInterface->CTLR |= 0x1fU;   // Enable group 0 and group 1, acknowledge both here (AckCtl), group 0 as FIQ (FIQEn), one binary point for both (CBPR)
+}
+
+// Returns the times IRQ_Handler ran the FIQ interrupt, see irq_route_fiq()
+uint32_t irq_get_fiq_in_irq(void){
+	return irq_fiq_in_irq;
+}
+
+/*
+    Sets whether an IRQ handler uses the floating point registers (VFP and
+    NEON), i.e. whether IRQ_Handler saves and restores them around it.
+        vfp: 1 = saved (default), 0 = integer only handler, not saved
+    An integer only handler must not use floating point or NEON anywhere,
+    including in the functions it calls and code the compiler vectorises,
+    e.g. memcpy() or printf() in the C library.  With -mfpu=neon the compiler
+    may also use the d registers for 64-bit moves, so mark the handler and its
+    callees with IRQ_INT_ONLY() for the build check (Makefile-app1.mk).  Inline
+    functions are only covered where they are inlined, not at -O0.
+*/
+void irq_set_vfp(IRQn_ID_t irqn, uint8_t vfp){
+	uint32_t bit;
+
+	if((irqn >= 0U) && (irqn < (IRQn_ID_t)IRQ_GIC_LINE_COUNT)){
+		bit = 1U << (irqn & 0x1fU);
+		if(vfp){
+			irq_int_only[irqn >> 5] &= ~bit;
+		}else{
+			irq_int_only[irqn >> 5] |= bit;
+		}
+	}
+}
+
 // Overrride CMSIS default weak prototype (see irq_ctrl_gic.h)
 IRQHandler_t IRQ_GetHandler(IRQn_ID_t irqn) {
 	IRQHandler_t h;
@@ -134,3 +339,61 @@ void irq_mask(uint8_t mask){
 	cpsr.b.I = mask;  // 1 = disable IRQ, 0 = enable IRQ
 	__set_CPSR(cpsr.w);
 }
+
+#if(TRU_IRQ_STATS == 1U)
+// Gives the time, as the global timer low word, at which the next run of an
+// interrupt is asserted, e.g. a global timer compare value.  Call before it
+// can fire.  Its dispatch then also records the latency from the assert
+void irq_stats_set_assert(IRQn_ID_t irqn, uint32_t assert_ticks){
+	if((irqn >= 0U) && (irqn < (IRQn_ID_t)IRQ_GIC_LINE_COUNT)){
+		irq_stats[irqn].assert_ticks = assert_ticks;
+		__DMB();
+		irq_stats[irqn].assert_armed = 1U;
+	}
+}
+
+// Copies the statistics of an interrupt, the handlers may update them meanwhile
+void irq_stats_get(IRQn_ID_t irqn, irq_stats_t *stats){
+	uint32_t cpsr = __get_CPSR();
+
+	if((irqn >= 0U) && (irqn < (IRQn_ID_t)IRQ_GIC_LINE_COUNT)){
+		__ASM volatile("CPSID if" : : : "memory");
+		*stats = irq_stats[irqn];
+		__set_CPSR(cpsr);
+	}
+}
+
+void irq_stats_reset(void){
+	uint32_t cpsr = __get_CPSR();
+
+	__ASM volatile("CPSID if" : : : "memory");
+	for(uint32_t i = 0U; i < IRQ_GIC_LINE_COUNT; i++){
+		irq_stats[i] = (irq_stats_t){ 0U };
+	}
+	__set_CPSR(cpsr);
+}
+
+// Prints a line for each interrupt that has run, times in ns.  The handler
+// time includes any time a higher priority interrupt preempted it.  The
+// dispatch and latency times are described with irq_stats_t.  The means are
+// taken in ticks before scaling, so the 64-bit totals of long runs can't
+// overflow
+void irq_stats_dump(uint32_t tick_hz){
+	irq_stats_t st;
+	uint32_t total_ms;
+
+	for(uint32_t i = 0U; i < IRQ_GIC_LINE_COUNT; i++){
+		irq_stats_get((IRQn_ID_t)i, &st);
+		if(st.count){
+			total_ms = (uint32_t)((st.total_ticks / tick_hz) * 1000U + (st.total_ticks % tick_hz) * 1000U / tick_hz);
+			printf("IRQ %u: count = %u, time = %u to %u ns, mean = %u ns, total = %u ms, dispatch = %u to %u ns, mean = %u ns\n", i, st.count,
+				(uint32_t)((uint64_t)st.min_ticks * 1000000000U / tick_hz), (uint32_t)((uint64_t)st.max_ticks * 1000000000U / tick_hz), (uint32_t)(st.total_ticks / st.count * 1000000000U / tick_hz), total_ms,
+				(uint32_t)((uint64_t)st.dispatch_min_ticks * 1000000000U / tick_hz), (uint32_t)((uint64_t)st.dispatch_max_ticks * 1000000000U / tick_hz), (uint32_t)(st.dispatch_total_ticks / st.count * 1000000000U / tick_hz));
+		}
+		if(st.latency_count){
+			printf("IRQ %u: assert to dispatch latency = %u to %u ns, mean = %u ns in %u runs\n", i,
+				(uint32_t)((uint64_t)st.latency_min_ticks * 1000000000U / tick_hz), (uint32_t)((uint64_t)st.latency_max_ticks * 1000000000U / tick_hz), (uint32_t)(st.latency_total_ticks / st.latency_count * 1000000000U / tick_hz), st.latency_count);
+		}
+	}
+}
+#endif
@@ -29,14 +29,26 @@
 	accelerometer (Analog Devices ADXL345) through the I2C interface.
 	Measurements are sent to the USB-UART port.  View them with a serial terminal
 	program with these settings: 115200 baud, 8 data bits, no parity and 1 stop
-	bit.
+	bit.  The define OPT_UART_BAUD switches to a higher rate after the start
+	message.
+
+	Output format
+	-------------
+
+	By default each sample is printed as a text line.  Setting the define
+	OPT_OUTPUT_BINARY to 1 sends the samples as binary telemetry frames instead
+	(see tru_telemetry.h for the layout), which needs about a third of the
+	bytes per sample.  Capture the raw stream and convert it to CSV with the
+	host decoder in tools/adxl345_decode.c.
 
 	I2C interface
 	-------------
 
 	On the DE10-Nano board the ADXL345 is configured for I2C and is connected to
 	the HPS I2C0 controller.  The I2C rate is 400kHz and it responds to the 7-bit
-	slave device address 0x53.
+	slave device address 0x53.  Setting the define OPT_ADXL345_MULTI to 1 also
+	reads the extra sensors listed in multi_sensor[], on I2C0 or other HPS I2C
+	controllers, taking turns with the on-board one.
 
 	Optional INT1 pin
 	-----------------
@@ -57,16 +69,74 @@
 #include "tru_c5soc_hps_i2c_ll.h"
 #include "tru_c5soc_hps_gpio_ll.h"
 #include "tru_adxl345_ll.h"
+#include "tru_adxl345_async.h"
+#include "tru_adxl345_dma.h"
+#include "tru_adxl345_ts.h"
+#include "tru_adxl345_wm.h"
+#include "tru_adxl345_cfg.h"
+#include "tru_adxl345_sched.h"
+#include "tru_adxl345_budget.h"
+#include "tru_adxl345_event.h"
+#include "tru_adxl345_pm.h"
+#include "tru_adxl345_ff.h"
+#include "tru_adxl345_cal.h"
+#include "tru_adxl345_st.h"
+#include "tru_c5soc_hps_uart_ll.h"
+#include "tru_c5soc_hps_uart_tx.h"
+#include "tru_c5soc_hps_uart_dma.h"
+#include "tru_c5soc_hps_sdmmc.h"
+#include "tru_cortex_a9.h"
+#include "tru_telemetry.h"
+#include "tru_defer.h"
 #include "tru_logger.h"
 
 // Intel HWLIB includes
 #include "alt_clock_manager.h"
 
+// I2C options
+#define OPT_I2C_SELFCHECK             1                         // 0 = off, 1 = report the effective SCL frequency and measured read throughput at startup
+#define OPT_I2C_SELFCHECK_READS       100                       // Number of 6 byte sample reads to time
+// Output options
+#define OPT_UART_BAUD                 0                         // 0 = keep the rate set by U-Boot, else switch UART0 to this rate at startup.  Exact rates with the 100MHz l4_sp_clk are 100MHz / (16 * n), e.g. 781250, 1562500 or 3125000
+#define OPT_OUTPUT_BINARY             0                         // 0 = text lines, 1 = binary telemetry frames
+#define OPT_OUTPUT_BENCH_SAMPLES      0                         // 0 = off, else number of test samples sent in each output format at startup to measure samples/s, e.g. 256
+#define OPT_OUTPUT_UART_DMA           0                         // 0 = CPU writes the binary frames to the UART, 1 = DMA sends the binary frames (requires OPT_OUTPUT_BINARY)
+// Max rate options
+#define OPT_ADXL345_MAX_RATE          0                         // 0 = off, 1 = 3200Hz streaming preset, overrides the rate and FIFO options below (requires binary output and OPT_UART_BAUD of 275000 or more, e.g. 781250)
+#define OPT_ADXL345_BUDGET_REPORT     0                         // 0 = off, else print the bus, CPU and output budget per sample every this many seconds
+// Timestamp options
+#define OPT_ADXL345_TS_REPORT         0                         // 0 = off, else print the estimated output data rate, drain jitter, loss and bus statistics every this many drains (text output only)
+// Polling options
+#define OPT_ADXL345_POLL_WAIT         0                         // 0 = poll the ADXL345 back-to-back, 1 = opt-in, wait on the timer until shortly before the next samples are due (fewer bus reads, later tap servicing)
+#define OPT_ADXL345_MULTI             0                         // 0 = on-board ADXL345 only, 1 = also poll the sensors listed in multi_sensor[] round-robin (requires polling, FIFO and text output)
 // Interrupt options
 #define OPT_ADXL345_INT1_ENABLE       0                         // 0 = polling mode, 1 = interrupt via INT1 pin
+#define OPT_ADXL345_I2C_ASYNC         0                         // 0 = blocking I2C reads, 1 = non-blocking interrupt driven I2C reads (requires INT1)
+#define OPT_ADXL345_I2C_DMA           0                         // 0 = CPU reads the FIFO samples, 1 = DMA reads the FIFO samples (requires INT1 and FIFO)
+#define OPT_IRQ_LATENCY_BENCH         0                         // 0 = off, else number of times the interrupt entry and exit times, and the latency at the INT1 priority while the UART interrupt is busy, are measured at startup, see TRU_IRQ_NESTED in tru_config.h
+#define OPT_ADXL345_INT1_DEFER        1                         // 0 = the INT1 handler does the readout, 1 = the INT1 handler only posts it to the main loop (blocking I2C only, else ignored)
+#define OPT_ADXL345_INT1_FIQ          0                         // 0 = INT1 is an IRQ, 1 = INT1 is the FIQ, which preempts the IRQ handlers (requires OPT_ADXL345_INT1_DEFER)
 // FIFO options
 #define OPT_ADXL345_FIFO_ENABLE       1                         // 0 = Bypass (don't use FIFO), 1 = FIFO mode (use FIFO)
-#define OPT_ADXL345_WATERLEVEL        1                         // 1 to 31 = sets the number of entries that will start a trigger
+#define OPT_ADXL345_WATERLEVEL        1                         // 1 to 31 = sets the number of entries that will start a trigger, the starting value when adaptive
+#define OPT_ADXL345_WM_ADAPT          0                         // 0 = fixed watermark, 1 = adapt the watermark at runtime (requires FIFO)
+#define OPT_ADXL345_WM_LATENCY_US     100000                    // Adaptive watermark: longest wait of the oldest FIFO entry before it is read
+#define OPT_ADXL345_WM_MAX_IRQ_HZ     200                       // Adaptive watermark: INT1 interrupt rate budget, 0 = none
+// Event capture options
+#define OPT_ADXL345_EVENT_CAPTURE     0                         // 0 = off, 1 = FIFO trigger mode: sleep until a tap or activity interrupt, then output the samples around it (requires INT1 and FIFO)
+#define OPT_ADXL345_EVENT_PRE         16                        // 1 to 31 = samples kept from before the trigger
+#define OPT_ADXL345_EVENT_POST        16                        // Samples after the trigger, at most TRU_ADXL345_EVENT_MAX less the above
+#define OPT_ADXL345_EVENT_ACTIVITY    0                         // 0 = taps trigger, 1 = activity on any axis also triggers
+#define OPT_ADXL345_ACT_THR           0x10                      // THRESH_ACT = THR * 62.5 mg, AC coupled, also the wake-on-motion threshold
+// Wake-on-motion options
+#define OPT_ADXL345_WAKE_ON_MOTION    0                         // 0 = off, 1 = the ADXL345 sleeps when inactive and wakes on activity, the CPU waits in WFI meanwhile (requires INT1 and FIFO, blocking I2C)
+#define OPT_ADXL345_INACT_THR         0x04                      // THRESH_INACT = THR * 62.5 mg, AC coupled
+#define OPT_ADXL345_INACT_TIME        5                         // Seconds below the inactivity threshold before sleeping
+#define OPT_ADXL345_WAKEUP            TRU_ADXL345_WAKEUP_8_HZ   // Activity sampling rate while asleep, see tru_adxl345_ll.h
+// Free-fall options
+#define OPT_ADXL345_FREEFALL          0                         // 0 = off, 1 = report free-falls from the INT1 interrupt with their latency (requires INT1, blocking I2C, a rate of 100Hz or faster)
+#define OPT_ADXL345_FF_THR_MG         400                       // Free-fall when all axes are below this, 300 to 600 mg suggested
+#define OPT_ADXL345_FF_TIME_MS        150                       // for at least this long, 100 to 350 ms suggested
 // Rate and range options
 #define OPT_ADXL345_RATE              TRU_ADXL345_RATE_3P13_HZ  // See tru_adxl345_ll.h for the list of rates
 #define OPT_ADXL345_RANGE             TRU_ADXL345_RANGE_2G      // See tru_adxl345_ll.h for the list of ranges
@@ -74,6 +144,15 @@
 #define OPT_ADXL345_OFSX              0                         // OFFSETX = OFSX * 15.6mg
 #define OPT_ADXL345_OFSY              0                         // OFFSETY = OFSY * 15.6mg
 #define OPT_ADXL345_OFSZ              0                         // OFFSETZ = OFSZ * 15.6mg
+#define OPT_ADXL345_CAL_LOAD          0                         // 0 = use the offsets above, 1 = use the offsets saved on the SD card by a calibration when there are any
+#define OPT_ADXL345_CAL_RUN           0                         // 0 = off, 1 = calibrate the offsets at startup with the board at rest, then save them to the SD card
+#define OPT_ADXL345_CAL_UP            TRU_ADXL345_CAL_Z_UP      // Axis facing up while calibrating, see tru_adxl345_cal.h
+#define OPT_ADXL345_CAL_SAMPLES       256                       // 1 to 65535 = samples averaged at 100Hz for the offsets, and again for the residual
+#define OPT_ADXL345_CAL_SD_BLOCK      2047                      // SD card sector holding the offsets, the last one before the first partition (see scripts-linux/sdcard/make-sd-tru.sh)
+// Self-test options
+#define OPT_ADXL345_SELFTEST          1                         // 0 = off, else run the self-test this many times at startup with the board at rest, and print the results and pass/fail statistics
+#define OPT_ADXL345_SELFTEST_SAMPLES  10                        // Samples averaged with the self-test off and again on, at 100Hz
+#define OPT_ADXL345_VS_MV             3300                      // ADXL345 supply voltage, the self-test limits scale with it
 // Tap detect options.  Tap only work with a fast measurement rate, e.g. 50Hz or more
 #define OPT_ADXL345_TAP_SINGLE_ENABLE 1
 #define OPT_ADXL345_TAP_DOUBLE_ENABLE 1
@@ -85,9 +164,85 @@
 #define OPT_ADXL345_TAP_LAT           0x3   // LATENT = LAT * 1.25ms
 #define OPT_ADXL345_TAP_WIN           0x50  // WINDOW = WIN * 1.25ms
 
+#if(OPT_ADXL345_MAX_RATE == 1)
+	// 3200Hz preset.  Each I2C drain moves half the FIFO, leaving 16 entries
+	// (5ms) for the drain and output time.  An entry costs 84 bits on the
+	// 400kHz bus, about 70% of it at this rate with the status reads
+	#undef OPT_ADXL345_RATE
+	#undef OPT_ADXL345_FIFO_ENABLE
+	#undef OPT_ADXL345_WATERLEVEL
+	#undef OPT_ADXL345_WM_ADAPT
+	#define OPT_ADXL345_RATE          TRU_ADXL345_RATE_3200_HZ
+	#define OPT_ADXL345_FIFO_ENABLE   1
+	#define OPT_ADXL345_WATERLEVEL    16
+	#define OPT_ADXL345_WM_ADAPT      0
+	#if(OPT_OUTPUT_BINARY == 0)
+		#error "OPT_ADXL345_MAX_RATE requires OPT_OUTPUT_BINARY"
+	#endif
+	#if((OPT_UART_BAUD / 10) < 3200 * TRU_TELEMETRY_FRAME_MAX / TRU_TELEMETRY_SAMPLES * 5 / 4)
+		#error "OPT_ADXL345_MAX_RATE requires OPT_UART_BAUD to carry 3200 samples/s of telemetry frames with 25% to spare"
+	#endif
+#endif
+#if(OPT_ADXL345_I2C_ASYNC == 1 && OPT_ADXL345_INT1_ENABLE == 0)
+	#error "OPT_ADXL345_I2C_ASYNC requires OPT_ADXL345_INT1_ENABLE"
+#endif
+#if(OPT_ADXL345_I2C_DMA == 1 && (OPT_ADXL345_INT1_ENABLE == 0 || OPT_ADXL345_FIFO_ENABLE == 0 || OPT_ADXL345_I2C_ASYNC == 1))
+	#error "OPT_ADXL345_I2C_DMA requires OPT_ADXL345_INT1_ENABLE and OPT_ADXL345_FIFO_ENABLE, and can't be used with OPT_ADXL345_I2C_ASYNC"
+#endif
+#if(OPT_ADXL345_EVENT_CAPTURE == 1 && (OPT_ADXL345_INT1_ENABLE == 0 || OPT_ADXL345_FIFO_ENABLE == 0 || OPT_ADXL345_I2C_ASYNC == 1 || OPT_ADXL345_I2C_DMA == 1 || OPT_ADXL345_WM_ADAPT == 1))
+	#error "OPT_ADXL345_EVENT_CAPTURE requires OPT_ADXL345_INT1_ENABLE and OPT_ADXL345_FIFO_ENABLE, and can't be used with OPT_ADXL345_I2C_ASYNC, OPT_ADXL345_I2C_DMA or OPT_ADXL345_WM_ADAPT"
+#endif
+#if(OPT_ADXL345_EVENT_CAPTURE == 1 && OPT_ADXL345_TAP_SINGLE_ENABLE == 0 && OPT_ADXL345_TAP_DOUBLE_ENABLE == 0 && OPT_ADXL345_EVENT_ACTIVITY == 0)
+	#error "OPT_ADXL345_EVENT_CAPTURE needs a trigger, enable a tap or OPT_ADXL345_EVENT_ACTIVITY"
+#endif
+#if(OPT_ADXL345_WAKE_ON_MOTION == 1 && (OPT_ADXL345_INT1_ENABLE == 0 || OPT_ADXL345_FIFO_ENABLE == 0 || OPT_ADXL345_I2C_ASYNC == 1 || OPT_ADXL345_I2C_DMA == 1 || OPT_ADXL345_EVENT_CAPTURE == 1))
+	#error "OPT_ADXL345_WAKE_ON_MOTION requires OPT_ADXL345_INT1_ENABLE and OPT_ADXL345_FIFO_ENABLE, and can't be used with OPT_ADXL345_I2C_ASYNC, OPT_ADXL345_I2C_DMA or OPT_ADXL345_EVENT_CAPTURE"
+#endif
+#if(OPT_ADXL345_FREEFALL == 1 && (OPT_ADXL345_INT1_ENABLE == 0 || OPT_ADXL345_I2C_ASYNC == 1 || OPT_ADXL345_I2C_DMA == 1 || OPT_ADXL345_EVENT_CAPTURE == 1))
+	#error "OPT_ADXL345_FREEFALL requires OPT_ADXL345_INT1_ENABLE, and can't be used with OPT_ADXL345_I2C_ASYNC, OPT_ADXL345_I2C_DMA or OPT_ADXL345_EVENT_CAPTURE"
+#endif
+// TIME_FF counts in 5ms steps but the device only checks it once per sample, so
+// below 100Hz a short drop ends before it is seen
+#if(OPT_ADXL345_FREEFALL == 1 && OPT_ADXL345_RATE < TRU_ADXL345_RATE_100_HZ)
+	#error "OPT_ADXL345_FREEFALL requires OPT_ADXL345_RATE of TRU_ADXL345_RATE_100_HZ or faster"
+#endif
+// OPT_ADXL345_INT1_FIQ works with TRU_IRQ_NESTED: an IRQ exception leaves
+// FIQs enabled, and the FIQ handler has its own banked LR, SPSR and stack, so
+// it can preempt IRQ_Handler anywhere, including its mode switch, and the IRQ
+// handlers running in SYS mode
+#if(OPT_ADXL345_INT1_FIQ == 1 && (OPT_ADXL345_INT1_ENABLE == 0 || OPT_ADXL345_INT1_DEFER == 0 || OPT_ADXL345_I2C_ASYNC == 1 || OPT_ADXL345_I2C_DMA == 1 || OPT_ADXL345_EVENT_CAPTURE == 1))
+	#error "OPT_ADXL345_INT1_FIQ requires OPT_ADXL345_INT1_ENABLE and OPT_ADXL345_INT1_DEFER, and can't be used with OPT_ADXL345_I2C_ASYNC, OPT_ADXL345_I2C_DMA or OPT_ADXL345_EVENT_CAPTURE"
+#endif
+#if(OPT_IRQ_LATENCY_BENCH > 0 && TRU_UART_TX_RING == 0U)
+	#error "OPT_IRQ_LATENCY_BENCH requires TRU_UART_TX_RING"
+#endif
+#if(OPT_ADXL345_CAL_SAMPLES < 1 || OPT_ADXL345_CAL_SAMPLES > 65535)
+	#error "OPT_ADXL345_CAL_SAMPLES must be 1 to 65535"
+#endif
+#if(OPT_ADXL345_WM_ADAPT == 1 && OPT_ADXL345_FIFO_ENABLE == 0)
+	#error "OPT_ADXL345_WM_ADAPT requires OPT_ADXL345_FIFO_ENABLE"
+#endif
+#if(OPT_ADXL345_MULTI == 1 && (OPT_ADXL345_INT1_ENABLE == 1 || OPT_ADXL345_FIFO_ENABLE == 0 || OPT_ADXL345_WM_ADAPT == 1 || OPT_OUTPUT_BINARY == 1 || OPT_ADXL345_BUDGET_REPORT > 0))
+	#error "OPT_ADXL345_MULTI requires polling, OPT_ADXL345_FIFO_ENABLE and text output, and can't be used with OPT_ADXL345_WM_ADAPT or OPT_ADXL345_BUDGET_REPORT"
+#endif
+#if(OPT_OUTPUT_UART_DMA == 1 && OPT_OUTPUT_BINARY == 0)
+	#error "OPT_OUTPUT_UART_DMA requires OPT_OUTPUT_BINARY"
+#endif
+#if(OPT_OUTPUT_UART_DMA == 1 && TRU_TELEMETRY_FRAME_MAX > TRU_HPS_UART_DMA_BUF_SIZE)
+	#error "A telemetry frame does not fit in TRU_HPS_UART_DMA_BUF_SIZE"
+#endif
+
+// DMA channels
+#define DMA_CHANNEL_I2C_TX  ALT_DMA_CHANNEL_0
+#define DMA_CHANNEL_I2C_RX  ALT_DMA_CHANNEL_1
+#define DMA_CHANNEL_UART_TX ALT_DMA_CHANNEL_2
+
 // DE10-Nano specific setting
 #define DE10N_ADXL345_INT1_GPIO_PINNUM 61
 
+// INT1 interrupt priority, above the UART, I2C and DMA so it preempts them with TRU_IRQ_NESTED
+#define INT1_IRQ_PRIORITY GIC_IRQ_PRIORITY_LEVEL27_0
+
 uint8_t buffer[1];
 
 typedef struct{
@@ -98,182 +253,1356 @@ typedef struct{
 
 typedef struct{
 	uint32_t l4_sp_clock_freq_hz;
+	uint32_t gtim_freq_hz;
 	uint32_t sample_count;
+	tru_adxl345_dev_t dev;
+	uint8_t watermark;
 	tru_adxl345_data sample;
+	tru_adxl345_ts_t ts;
+#if(OPT_ADXL345_WM_ADAPT == 1)
+	tru_adxl345_wm_t wm;
+#endif
+#if(OPT_ADXL345_BUDGET_REPORT > 0)
+	tru_adxl345_budget_t budget;
+	uint32_t out_bytes;             // Output bytes sent
+	uint64_t budget_report_ticks;   // Last budget report
+	uint32_t budget_irq_ticks;      // INT1 and I2C0 handler time not yet added to the budget
+#endif
+#if(OPT_ADXL345_WAKE_ON_MOTION == 1)
+	tru_adxl345_pm_t pm;
+#endif
+#if(OPT_ADXL345_FREEFALL == 1)
+	tru_adxl345_ff_t ff;
+#endif
+#if(OPT_ADXL345_I2C_ASYNC == 0 && OPT_ADXL345_I2C_DMA == 0 && OPT_ADXL345_EVENT_CAPTURE == 0)
+	uint32_t irq_count;             // INT1 handler runs
+	uint32_t irq_max_ticks;         // Longest INT1 handler, i.e. time with IRQs masked
+	uint64_t irq_sum_ticks;
+#endif
 }tru_adxl345_accel_t;
 
 tru_adxl345_accel_t accel;
+tru_adxl345_data fifo_sample[TRU_ADXL345_FIFO_DEPTH];
+#if OPT_OUTPUT_BINARY == 1
+tru_telemetry_t telemetry;
+#endif
+
+// Start the global timer, it is the time source for measurements and timestamps
+void setup_timer(void){
+	// It is clocked by the peripheral base clock
+	alt_clk_freq_get(ALT_CLK_MPU_PERIPH, &accel.gtim_freq_hz);
+	gtim_setup_basic_mode();
+	gtim_enable();
+}
+
+uint32_t timestamp_us(void){
+	return (uint32_t)(gtim_get_counter() / (accel.gtim_freq_hz / 1000000U));
+}
+
+#if(TRU_UART_TX_RING == 1U)
+// Move printf and telemetry output to the interrupt driven transmit ring buffer
+void setup_uart_tx(void){
+	fflush(stdout);
+	tru_hps_uart_tx_init((TRU_TARGET_TYPE *)TRU_HPS_UART0_BASE);
+
+	IRQ_SetHandler(C5SOC_UART0_IRQn, tru_hps_uart_tx_irq_handler);  // Register the ring buffer handler
+	IRQ_SetPriority(C5SOC_UART0_IRQn, GIC_IRQ_PRIORITY_LEVEL29_0);
+	IRQ_SetMode(C5SOC_UART0_IRQn, IRQ_MODE_TYPE_IRQ | IRQ_MODE_CPU_0 | IRQ_MODE_TRIG_LEVEL | IRQ_MODE_TRIG_LEVEL_HIGH);
+	IRQ_Enable(C5SOC_UART0_IRQn);  // Enable the interrupt
+	irq_mask(0);  // Enable IRQ mode interrupts for this CPU
+}
+#endif
+
+#if(OPT_UART_BAUD > 0)
+// Switch the UART to the high rate, the new rate is reported at the new rate
+void setup_uart_baud(void){
+	tru_hps_uart_baud_t baud;
+	uint32_t err_ppm;
+
+	printf("Switching UART to %u baud\n", OPT_UART_BAUD);
+	fflush(stdout);
+#if(TRU_UART_TX_RING == 1U)
+	tru_hps_uart_tx_flush();
+#endif
+
+	if(tru_hps_uart_ll_config((TRU_TARGET_TYPE *)TRU_HPS_UART0_BASE, accel.l4_sp_clock_freq_hz, OPT_UART_BAUD, TRU_HPS_UART_LCR_8N1, &baud)){
+		err_ppm = (baud.err_ppm < 0) ? -baud.err_ppm : baud.err_ppm;
+		printf("UART baud = %u (divisor = %u, error = %c%u.%.2u%%)\n", baud.baud, baud.divisor, (baud.err_ppm < 0) ? '-' : '+', err_ppm / 10000U, (err_ppm / 100U) % 100U);
+	}else if(baud.err_ppm > TRU_HPS_UART_BAUD_MAX_ERR_PPM || baud.err_ppm < -TRU_HPS_UART_BAUD_MAX_ERR_PPM){
+		printf("Error: closest UART baud = %u is too far from %u\n", baud.baud, OPT_UART_BAUD);
+	}else{
+		printf("Error: UART busy receiving, baud not changed\n");
+	}
+}
+#endif
+
+#if(OPT_ADXL345_I2C_DMA == 1 || OPT_OUTPUT_UART_DMA == 1)
+// Initialise the DMA controller, shared by the I2C and UART transfers
+void setup_dma(void){
+	ALT_DMA_CFG_t dma_cfg;
+
+	// Default security and peripheral MUX settings
+	dma_cfg.manager_sec = ALT_DMA_SECURITY_DEFAULT;
+	for(uint32_t i = 0; i < 8; i++) dma_cfg.irq_sec[i] = ALT_DMA_SECURITY_DEFAULT;
+	for(uint32_t i = 0; i < 32; i++) dma_cfg.periph_sec[i] = ALT_DMA_SECURITY_DEFAULT;
+	for(uint32_t i = 0; i < 4; i++) dma_cfg.periph_mux[i] = ALT_DMA_PERIPH_MUX_DEFAULT;
+
+	if(alt_dma_init(&dma_cfg) != ALT_E_SUCCESS){
+		printf("Error: DMA init failed\n");
+	}
+}
+#endif
+
+#if(OPT_OUTPUT_UART_DMA == 1)
+// Binary frames are sent by DMA from here on, printf text still goes through
+// the CPU and can interleave with a frame, which the host decoder then drops
+void setup_uart_dma(void){
+	fflush(stdout);
+#if(TRU_UART_TX_RING == 1U)
+	tru_hps_uart_tx_flush();
+#endif
+	if(tru_hps_uart_dma_init((TRU_TARGET_TYPE *)TRU_HPS_UART0_BASE, DMA_CHANNEL_UART_TX) != ALT_E_SUCCESS){
+		printf("Error: UART DMA init failed\n");
+	}
+}
+#endif
+
+// Binary frames bypass stdout, it would insert '\r'
+void output_write_frame(const uint8_t *frame, uint32_t len){
+	if(len == 0) return;
+#if(OPT_ADXL345_BUDGET_REPORT > 0)
+	accel.out_bytes += len;
+#endif
+#if(OPT_OUTPUT_UART_DMA == 1)
+	// Frames assembled in place are sent as they are, the next one is
+	// assembled in the other buffer meanwhile.  A copied write uses up that
+	// buffer too, so either way telemetry.frame moves on
+	if(frame == telemetry.frame){
+		tru_hps_uart_dma_send(frame, len);
+	}else{
+		tru_hps_uart_dma_write(frame, len);
+	}
+	telemetry.frame = tru_hps_uart_dma_next_buf();
+#elif(TRU_UART_TX_RING == 1U)
+	tru_hps_uart_tx_write(frame, len);
+#else
+	tru_hps_uart_ll_write_bin((TRU_TARGET_TYPE *)TRU_HPS_UART0_BASE, frame, len);
+#endif
+}
+
+// Blocking wait until all output has been transmitted
+void output_wait_empty(void){
+	fflush(stdout);
+#if(OPT_OUTPUT_UART_DMA == 1)
+	tru_hps_uart_dma_wait();
+#endif
+#if(TRU_UART_TX_RING == 1U)
+	tru_hps_uart_tx_flush();
+#else
+	tru_hps_uart_ll_wait_empty((TRU_TARGET_TYPE *)TRU_HPS_UART0_BASE);
+#endif
+}
+
+// Called once before streaming starts
+void output_start(void){
+#if OPT_OUTPUT_BINARY == 1
+	const uint8_t delimiter = 0;
+
+	fflush(stdout);
+	tru_telemetry_init(&telemetry);
+#if(OPT_OUTPUT_UART_DMA == 1)
+	telemetry.frame = tru_hps_uart_dma_next_buf();  // Assemble frames in the DMA buffers
+#endif
+	output_write_frame(&delimiter, 1);  // Separate the first frame from the preceding text
+#endif
+}
+
+void output_sample(const tru_adxl345_data *sample, uint32_t ts_us){
+#if OPT_OUTPUT_BINARY == 1
+	output_write_frame(telemetry.frame, tru_telemetry_add(&telemetry, ts_us, sample->x, sample->y, sample->z));
+#elif(OPT_ADXL345_BUDGET_REPORT > 0)
+	accel.out_bytes += printf("%.10u: t=%.10u x=%-4i y=%-4i z=%-4i\n", accel.sample_count, ts_us, sample->x, sample->y, sample->z);
+#else
+	printf("%.10u: t=%.10u x=%-4i y=%-4i z=%-4i\n", accel.sample_count, ts_us, sample->x, sample->y, sample->z);
+#endif
+	accel.sample_count++;
+}
+
+// Called after each batch of samples, sends a partly filled frame so the latency
+// stays at one batch
+void output_flush(void){
+#if OPT_OUTPUT_BINARY == 1
+	output_write_frame(telemetry.frame, tru_telemetry_flush(&telemetry));
+#endif
+}
+
+#if(OPT_ADXL345_TS_REPORT > 0 && OPT_OUTPUT_BINARY == 0)
+void report_ts(void){
+	tru_adxl345_ts_stats_t stats;
+	tru_adxl345_i2c_stats_t i2c_stats;
+	tru_adxl345_shadow_stats_t shadow_stats;
+
+	tru_adxl345_ts_get_stats(&accel.ts, &stats);
+	printf("ODR = %u.%.3u Hz (drift = %i ppm), drain jitter = %i to %i us, mean = %u us, resyncs = %u\n", stats.odr_mhz / 1000U, stats.odr_mhz % 1000U, stats.drift_ppm, stats.jitter_min_us, stats.jitter_max_us, stats.jitter_mean_us, stats.resyncs);
+	printf("Samples read = %u, lost = %u in %u gaps, overruns = %u, late drains = %u\n", stats.read, stats.lost, stats.gaps, stats.overruns, stats.late);
+	tru_adxl345_i2c_get_stats(accel.dev.i2c_base, &i2c_stats);
+	tru_adxl345_shadow_get_stats(&accel.dev, &shadow_stats);
+	printf("I2C reads = %u (%u bytes), writes = %u (%u bytes), shadow hits = %u\n", i2c_stats.reads, i2c_stats.read_bytes, i2c_stats.writes, i2c_stats.write_bytes, shadow_stats.hits);
+#if(OPT_ADXL345_WM_ADAPT == 1)
+	tru_adxl345_wm_stats_t wm_stats;
+
+	tru_adxl345_wm_get_stats(&accel.wm, &wm_stats);
+	printf("Watermark = %u (%u to %u, changes = %u), interrupt rate = %u.%.3u Hz, drain time = %u us\n", wm_stats.watermark, wm_stats.lo, wm_stats.hi, wm_stats.changes, wm_stats.irq_mhz / 1000U, wm_stats.irq_mhz % 1000U, wm_stats.busy_us);
+#endif
+#if(OPT_ADXL345_WAKE_ON_MOTION == 1)
+	tru_adxl345_pm_stats_t pm_stats;
+
+	tru_adxl345_pm_get_stats(&accel.pm, gtim_get_counter(), &pm_stats);
+	printf("Sleeps = %u, wakes = %u, asleep = %u%%, wake latency = %u to %u us, mean = %u us, plus up to %u us detection\n", pm_stats.sleeps, pm_stats.wakes, pm_stats.asleep_pct, pm_stats.latency_min_us, pm_stats.latency_max_us, pm_stats.latency_mean_us, pm_stats.detect_max_us);
+#endif
+#if(OPT_ADXL345_FREEFALL == 1)
+	tru_adxl345_ff_stats_t ff_stats;
+
+	tru_adxl345_ff_get_stats(&accel.ff, &ff_stats);
+	printf("Free-falls = %u, notify = %u to %u us, mean = %u us, onset to notify <= %u us (fall %u + detect %u + notify)\n", ff_stats.events, ff_stats.notify_min_us, ff_stats.notify_max_us, ff_stats.notify_mean_us, ff_stats.onset_max_us, ff_stats.fall_us, ff_stats.detect_max_us);
+#endif
+#if(OPT_ADXL345_INT1_ENABLE == 1 && OPT_ADXL345_I2C_ASYNC == 0 && OPT_ADXL345_I2C_DMA == 0 && OPT_ADXL345_EVENT_CAPTURE == 0)
+	uint32_t irq_mean_us = accel.irq_count ? (uint32_t)tru_adxl345_ts_to_us(&accel.ts, accel.irq_sum_ticks / accel.irq_count) : 0;
+
+	printf("INT1 handler runs = %u, IRQs masked for up to %u us, mean = %u us\n", accel.irq_count, (uint32_t)tru_adxl345_ts_to_us(&accel.ts, accel.irq_max_ticks), irq_mean_us);
+#endif
+#if(OPT_ADXL345_INT1_ENABLE == 1 && OPT_ADXL345_INT1_DEFER == 1 && OPT_ADXL345_I2C_ASYNC == 0 && OPT_ADXL345_I2C_DMA == 0 && OPT_ADXL345_EVENT_CAPTURE == 0)
+	tru_defer_stats_t defer_stats;
+
+	tru_defer_get_stats(&defer_stats);
+	printf("Deferred = %u, run = %u, full = %u, queued <= %u, wait <= %u us, bottom half <= %u us\n", defer_stats.posted, defer_stats.run, defer_stats.full, defer_stats.high_water, (uint32_t)tru_adxl345_ts_to_us(&accel.ts, defer_stats.wait_max_ticks), (uint32_t)tru_adxl345_ts_to_us(&accel.ts, defer_stats.run_max_ticks));
+#if(OPT_ADXL345_INT1_FIQ == 1)
+	printf("FIQs taken as IRQ = %u\n", irq_get_fiq_in_irq());  // See irq_route_fiq()
+#endif
+#endif
+#if(TRU_IRQ_STATS == 1U)
+	irq_stats_dump(accel.gtim_freq_hz);
+#endif
+}
+#endif
+
+#if(OPT_ADXL345_BUDGET_REPORT > 0)
+// Starts the budget measurement, call right before streaming
+void budget_start(void){
+	tru_adxl345_i2c_scl_t scl;
+	tru_adxl345_i2c_stats_t i2c_stats;
+	uint32_t scl_freq_hz = tru_adxl345_i2c_scl_readback(&accel.dev, accel.l4_sp_clock_freq_hz, &scl);
+
+	tru_adxl345_i2c_get_stats(accel.dev.i2c_base, &i2c_stats);
+	accel.budget_report_ticks = gtim_get_counter();
+	accel.budget_irq_ticks = 0;
+	tru_adxl345_budget_init(&accel.budget, accel.gtim_freq_hz, tru_adxl345_rate_to_mhz(OPT_ADXL345_RATE), scl_freq_hz, OPT_UART_BAUD ? OPT_UART_BAUD : 115200U, accel.budget_report_ticks, &i2c_stats);
+}
+
+void report_budget(void){
+	tru_adxl345_i2c_stats_t i2c_stats;
+	tru_adxl345_budget_report_t r;
+#if OPT_OUTPUT_BINARY == 1
+	const uint8_t delimiter = 0;
+#endif
+
+	tru_adxl345_i2c_get_stats(accel.dev.i2c_base, &i2c_stats);
+	tru_adxl345_budget_get_report(&accel.budget, gtim_get_counter(), &i2c_stats, &r);
+
+#if(OPT_OUTPUT_UART_DMA == 1)
+	output_wait_empty();  // Text is sent by the CPU, don't mix it into a DMA frame
+#endif
+	printf("Budget: %u samples at %u.%.3u Hz, per sample (period %u ns): bus = %u ns, CPU = %u ns + %u ns bus wait, output = %u.%.2u bytes\n", r.samples, r.odr_mhz / 1000U, r.odr_mhz % 1000U, r.period_ns, r.bus_ns, r.cpu_ns, r.wait_ns, r.out_bytes_x100 / 100U, r.out_bytes_x100 % 100U);
+	printf("Budget: load bus = %u%%, CPU = %u%%, UART = %u%%, headroom = %u%%, sensors per bus = %u, per core = %u, per UART = %u\n", r.bus_pct, r.cpu_pct, r.uart_pct, r.headroom_pct, r.sensors_bus, r.sensors_cpu, r.sensors_uart);
+#if OPT_OUTPUT_BINARY == 1
+	// End the text like a frame, the decoder counts it as one bad frame
+	fflush(stdout);
+#if(OPT_OUTPUT_UART_DMA == 1)
+	output_wait_empty();
+#endif
+	output_write_frame(&delimiter, 1);
+#endif
+}
+
+// Adds a drain of n samples to the budget.  wait_ticks is the time from the
+// watermark to the output start, output_ticks the output start and out_bytes
+// the output byte count then
+void budget_drain(uint32_t n, uint64_t wait_ticks, uint64_t output_ticks, uint32_t out_bytes){
+	uint64_t ticks = gtim_get_counter();
+
+#if(OPT_ADXL345_I2C_ASYNC == 1 || OPT_ADXL345_I2C_DMA == 1)
+	// The transfers don't block the CPU, only the interrupt handlers do
+	wait_ticks = accel.budget_irq_ticks;
+	accel.budget_irq_ticks = 0;
+#endif
+	tru_adxl345_budget_drain(&accel.budget, n, (uint32_t)wait_ticks, (uint32_t)(ticks - output_ticks), accel.out_bytes - out_bytes);
+
+	if(ticks - accel.budget_report_ticks >= (uint64_t)OPT_ADXL345_BUDGET_REPORT * accel.gtim_freq_hz){
+		accel.budget_report_ticks = ticks;
+		report_budget();
+	}
+}
+#endif
+
+// Timestamp of entry i of the last drain of n entries, in microseconds
+uint32_t sample_us(uint32_t n, uint32_t i){
+	return (uint32_t)tru_adxl345_ts_to_us(&accel.ts, tru_adxl345_ts_sample(&accel.ts, n, i));
+}
+
+#if(OPT_ADXL345_WM_ADAPT == 1)
+#if(OPT_ADXL345_I2C_ASYNC == 1)
+tru_adxl345_i2c_xfer_t xfer_fifo_ctl;
+tru_adxl345_fifo_ctl_t async_fifo_ctl;
+#endif
+
+// Reprograms the watermark.  The FIFO mode stays the same, so the entries are
+// kept and the measurement carries on
+void write_watermark(uint8_t watermark){
+#if(OPT_ADXL345_I2C_ASYNC == 1)
+	tru_adxl345_shadow(&accel.dev)->fifo_ctl.bits.samples = watermark;
+	async_fifo_ctl = tru_adxl345_shadow(&accel.dev)->fifo_ctl;
+	xfer_fifo_ctl.dir = TRU_ADXL345_I2C_XFER_WRITE;
+	xfer_fifo_ctl.reg_addr = TRU_ADXL345_FIFO_CTL_ADDR;
+	xfer_fifo_ctl.len = 1;
+	xfer_fifo_ctl.buf = &async_fifo_ctl.val;
+	xfer_fifo_ctl.callback = 0;
+	tru_adxl345_i2c_async_submit(&xfer_fifo_ctl);
+	tru_adxl345_shadow_written(&accel.dev, TRU_ADXL345_FIFO_CTL_ADDR, 1);
+#else
+	tru_adxl345_shadow(&accel.dev)->fifo_ctl.bits.samples = watermark;
+	tru_adxl345_shadow_flush(&accel.dev);
+#endif
+}
+
+// Output path fill level in percent
+uint32_t output_backlog_pct(void){
+#if(TRU_UART_TX_RING == 1U)
+	return tru_hps_uart_tx_used() * 100U / TRU_UART_TX_SIZE;
+#else
+	return 0;
+#endif
+}
+
+// Called after a drain of n entries whose watermark was seen at ticks has been
+// output, moves the watermark if the controller asks for it
+void adapt_watermark(uint32_t n, uint64_t ticks){
+	uint8_t watermark = tru_adxl345_wm_update(&accel.wm, ticks, n, (uint32_t)(gtim_get_counter() - ticks), output_backlog_pct());
+
+	if(watermark){
+		write_watermark(watermark);
+		accel.watermark = watermark;
+		tru_adxl345_ts_set_watermark(&accel.ts, watermark);
+	}
+}
+#endif
+
+// Marks the samples lost before the last drain of n entries in the stream, and
+// skips their sample numbers
+void output_gap(uint32_t n){
+	uint32_t lost = accel.ts.gap;
+
+#if OPT_OUTPUT_BINARY == 1
+	output_flush();
+	output_write_frame(telemetry.frame, tru_telemetry_gap(&telemetry, sample_us(n + lost, 0), lost));
+#else
+	printf("%.10u: t=%.10u GAP lost=%u\n", accel.sample_count, sample_us(n + lost, 0), lost);
+#endif
+	accel.sample_count += lost;
+}
+
+// Timestamps a drain of n entries whose watermark was seen at the global timer
+// count ticks, and marks any samples lost before it
+void output_drain_start(uint32_t n, uint64_t ticks, tru_adxl345_int_source_t int_source){
+	tru_adxl345_ts_drain(&accel.ts, ticks, n, int_source.bits.overrun);
+	if(accel.ts.gap) output_gap(n);
+}
+
+// Output a drain of n samples, the oldest first
+void output_drain(const tru_adxl345_data *sample, uint32_t n, uint64_t ticks, tru_adxl345_int_source_t int_source){
+#if(OPT_ADXL345_BUDGET_REPORT > 0)
+	uint64_t output_ticks = gtim_get_counter();
+	uint32_t out_bytes = accel.out_bytes;
+#endif
+
+	output_drain_start(n, ticks, int_source);
+	for(uint32_t i = 0; i < n; i++){
+		output_sample(&sample[i], sample_us(n, i));
+	}
+	output_flush();
+#if(OPT_ADXL345_BUDGET_REPORT > 0)
+	budget_drain(n, output_ticks - ticks, output_ticks, out_bytes);
+#endif
+#if(OPT_ADXL345_WM_ADAPT == 1)
+	adapt_watermark(n, ticks);
+#endif
+
+#if(OPT_ADXL345_TS_REPORT > 0 && OPT_OUTPUT_BINARY == 0)
+	if(accel.ts.drains % OPT_ADXL345_TS_REPORT == 0) report_ts();
+#endif
+}
+
+void output_tap(tru_adxl345_int_source_t int_source){
+#if OPT_OUTPUT_BINARY == 1
+	if(int_source.bits.singletap) tru_telemetry_set_flags(&telemetry, TRU_TELEMETRY_FLAG_SINGLETAP);
+	if(int_source.bits.doubletap) tru_telemetry_set_flags(&telemetry, TRU_TELEMETRY_FLAG_DOUBLETAP);
+#else
+	if(int_source.bits.singletap && int_source.bits.doubletap){
+		printf("%.10u: TAPPED + DOUBLE\n", accel.sample_count);
+	}else if(int_source.bits.singletap){
+		printf("%.10u: TAPPED\n", accel.sample_count);
+	}
+#endif
+}
+
+#if(OPT_ADXL345_FREEFALL == 1)
+// Free-fall seen by the INT1 handler entered at irq_ticks, known to be one at
+// notify_ticks
+void output_freefall(uint64_t irq_ticks, uint64_t notify_ticks){
+	uint64_t onset_ticks = tru_adxl345_ff_event(&accel.ff, irq_ticks, notify_ticks);
+
+#if OPT_OUTPUT_BINARY == 1
+	(void)onset_ticks;
+	tru_telemetry_set_flags(&telemetry, TRU_TELEMETRY_FLAG_FREEFALL);
+#else
+	printf("%.10u: t=%.10u FREEFALL onset=%.10u notify=%u us\n", accel.sample_count, (uint32_t)tru_adxl345_ts_to_us(&accel.ts, irq_ticks), (uint32_t)tru_adxl345_ts_to_us(&accel.ts, onset_ticks), (uint32_t)tru_adxl345_ts_to_us(&accel.ts, notify_ticks - irq_ticks));
+#endif
+}
+#endif
+
+// Restarts the timestamp and watermark estimates for an output data rate
+void setup_rate(uint8_t rate){
+	tru_adxl345_ts_init(&accel.ts, accel.gtim_freq_hz, tru_adxl345_rate_to_mhz(rate));
+#if OPT_ADXL345_FIFO_ENABLE == 1
+	accel.watermark = OPT_ADXL345_WATERLEVEL;
+#if(OPT_ADXL345_WM_ADAPT == 1)
+	tru_adxl345_wm_init(&accel.wm, accel.gtim_freq_hz, tru_adxl345_rate_to_mhz(rate), OPT_ADXL345_WATERLEVEL, OPT_ADXL345_WM_LATENCY_US, OPT_ADXL345_WM_MAX_IRQ_HZ);
+	accel.watermark = accel.wm.watermark;
+#endif
+	tru_adxl345_ts_set_watermark(&accel.ts, accel.watermark);
+#else
+	accel.watermark = 1;
+#endif
+}
+
+// Builds the ADXL345 configuration from the options
+void config_from_options(tru_adxl345_config_t *cfg){
+	tru_adxl345_config_reset(cfg);
+
+	// Calibration offsets
+	cfg->ofsx = OPT_ADXL345_OFSX;
+	cfg->ofsy = OPT_ADXL345_OFSY;
+	cfg->ofsz = OPT_ADXL345_OFSZ;
+
+#if OPT_ADXL345_TAP_SINGLE_ENABLE == 1 || OPT_ADXL345_TAP_DOUBLE_ENABLE == 1
+	cfg->thresh_tap = OPT_ADXL345_TAP_THR;
+	cfg->dur = OPT_ADXL345_TAP_DUR;
+	cfg->latent = OPT_ADXL345_TAP_LAT;
+	cfg->window = OPT_ADXL345_TAP_WIN;
+	cfg->tap_axes.bits.tap_x_en = OPT_ADXL345_TAP_X_ENABLE;
+	cfg->tap_axes.bits.tap_y_en = OPT_ADXL345_TAP_Y_ENABLE;
+	cfg->tap_axes.bits.tap_z_en = OPT_ADXL345_TAP_Z_ENABLE;
+#endif
+
+	// Output rate
+	cfg->bw_rate.bits.rate = OPT_ADXL345_RATE;
+
+	// Data options
+	cfg->data_format.bits.range = OPT_ADXL345_RANGE;
+	cfg->data_format.bits.fullres = 1;
+	cfg->data_format.bits.intinvert = 1;
+
+#if(OPT_ADXL345_EVENT_CAPTURE == 1)
+	// Trigger mode, keeps the history before the trigger (see tru_adxl345_event.c)
+	cfg->fifo_ctl.bits.fifomode = TRU_ADXL345_FIFOMODE_TRIGGER;
+	cfg->fifo_ctl.bits.samples = OPT_ADXL345_EVENT_PRE;
+#elif OPT_ADXL345_FIFO_ENABLE == 1
+	// FIFO mode
+	cfg->fifo_ctl.bits.fifomode = TRU_ADXL345_FIFOMODE_STREAM;
+	cfg->fifo_ctl.bits.samples = accel.watermark;
+#else
+	// FIFO mode off
+	cfg->fifo_ctl.bits.fifomode = TRU_ADXL345_FIFOMODE_BYPASS;
+	cfg->fifo_ctl.bits.samples = 16;
+#endif
+
+#if(OPT_ADXL345_EVENT_CAPTURE == 1 && OPT_ADXL345_EVENT_ACTIVITY == 1)
+	// Activity on any axis, AC coupled so gravity doesn't count
+	cfg->thresh_act = OPT_ADXL345_ACT_THR;
+	cfg->act_inact_ctl.bits.act_acdc = 1;
+	cfg->act_inact_ctl.bits.act_x_en = 1;
+	cfg->act_inact_ctl.bits.act_y_en = 1;
+	cfg->act_inact_ctl.bits.act_z_en = 1;
+#endif
+
+	// Which triggers generate interrupts, all on the INT1 pin
+#if(OPT_ADXL345_EVENT_CAPTURE == 1)
+	// Only the trigger sources until an event, see tru_adxl345_event.c
+	cfg->int_enable.bits.activity = OPT_ADXL345_EVENT_ACTIVITY;
+	cfg->int_enable.bits.doubletap = OPT_ADXL345_TAP_DOUBLE_ENABLE;
+	cfg->int_enable.bits.singletap = OPT_ADXL345_TAP_SINGLE_ENABLE;
+#else
+	cfg->int_enable.bits.watermark = OPT_ADXL345_FIFO_ENABLE;
+	cfg->int_enable.bits.doubletap = OPT_ADXL345_TAP_DOUBLE_ENABLE;
+	cfg->int_enable.bits.singletap = OPT_ADXL345_TAP_SINGLE_ENABLE;
+	cfg->int_enable.bits.dataready = 1;
+#endif
+	cfg->int_map.val = 0x0;
+
+#if(OPT_ADXL345_WAKE_ON_MOTION == 1)
+	// Sleep on inactivity and wake on activity, see tru_adxl345_pm.c
+	tru_adxl345_pm_config(cfg, OPT_ADXL345_ACT_THR, OPT_ADXL345_INACT_THR, OPT_ADXL345_INACT_TIME, OPT_ADXL345_WAKEUP);
+#endif
+#if(OPT_ADXL345_FREEFALL == 1)
+	tru_adxl345_ff_config(cfg, OPT_ADXL345_FF_THR_MG, OPT_ADXL345_FF_TIME_MS);
+#endif
+
+	// Start measuring
+	cfg->power_ctl.bits.measure = 1;
+}
+
+#if(OPT_ADXL345_CAL_LOAD == 1 || OPT_ADXL345_CAL_RUN == 1)
+uint32_t cal_block[TRU_HPS_SDMMC_BLOCK_SIZE / 4U];
+
+void setup_sdmmc(void){
+	if(tru_hps_sdmmc_init() != ALT_E_SUCCESS) printf("SD card not found, the offsets can't be loaded or saved\n");
+}
+
+// Reads the calibration record saved on the SD card, returns 1 if there is one
+uint8_t cal_read(tru_adxl345_cal_record_t *rec){
+	if(tru_hps_sdmmc_read_block(OPT_ADXL345_CAL_SD_BLOCK, cal_block) != ALT_E_SUCCESS) return 0;
+	return tru_adxl345_cal_unpack(rec, (const uint8_t *)cal_block);
+}
+#endif
+
+#if(OPT_ADXL345_CAL_LOAD == 1)
+// Replaces the offsets of a configuration with the saved ones
+void cal_load(tru_adxl345_config_t *cfg){
+	tru_adxl345_cal_record_t rec;
+
+	if(!cal_read(&rec)){
+		printf("No saved offsets, using the options\n");
+		return;
+	}
+	cfg->ofsx = rec.ofs[0];
+	cfg->ofsy = rec.ofs[1];
+	cfg->ofsz = rec.ofs[2];
+	printf("Offsets loaded: x = %i, y = %i, z = %i (calibration %u, residual = %i, %i, %i ug)\n", rec.ofs[0], rec.ofs[1], rec.ofs[2], rec.count, rec.residual_ug[0], rec.residual_ug[1], rec.residual_ug[2]);
+}
+#endif
 
 void setup_adxl345(void){
-	accel.sample_count = 0;
+	uint32_t writes;
 
-	// Get the L4 Slave Peripheral clock frequency
-	alt_clk_freq_get(ALT_CLK_L4_SP, &accel.l4_sp_clock_freq_hz);
-	//printf("L4_SP_CLK = %u Hz\n", accel.l4_sp_clock_freq_hz);
+	accel.sample_count = 0;
 
 	// Initialise
-	tru_adxl345_i2c_init(accel.l4_sp_clock_freq_hz, TRU_ADXL345_I2C_SPEED_KHZ, TRU_HPS_I2C_CON_ADDR_7BIT, TRU_ADXL345_I2C_DEV_ADDR);
+	tru_adxl345_dev_init(&accel.dev, TRU_HPS_I2C0_BASE, TRU_ADXL345_I2C_DEV_ADDR);
+	tru_adxl345_i2c_init(&accel.dev, accel.l4_sp_clock_freq_hz, TRU_ADXL345_I2C_SPEED_KHZ);
 
 	// Read ADXL345 device ID from the ADXL345
-	tru_adxl345_i2c_read(buffer, 1, TRU_ADXL345_DEVID_ADDR);
+	tru_adxl345_i2c_read(&accel.dev, buffer, 1, TRU_ADXL345_DEVID_ADDR);
 	printf("Device ID: 0x%.2x\n", buffer[0]);
 
-	tru_adxl345_i2c_stop_flush_fifo();
+	tru_adxl345_i2c_stop_flush_fifo(&accel.dev);
+	setup_rate(OPT_ADXL345_RATE);
 
-	// Set calibration offsets
-	buffer[0] = OPT_ADXL345_OFSX;
-	tru_adxl345_i2c_write(buffer, 1, TRU_ADXL345_OFSX_ADDR);
-	buffer[0] = OPT_ADXL345_OFSY;
-	tru_adxl345_i2c_write(buffer, 1, TRU_ADXL345_OFSY_ADDR);
-	buffer[0] = OPT_ADXL345_OFSZ;
-	tru_adxl345_i2c_write(buffer, 1, TRU_ADXL345_OFSZ_ADDR);
+	// Only the registers that differ from what the device holds are written,
+	// contiguous ones in one transaction
+	tru_adxl345_shadow_load(&accel.dev);
+	config_from_options(tru_adxl345_shadow(&accel.dev));
+#if(OPT_ADXL345_CAL_LOAD == 1)
+	cal_load(tru_adxl345_shadow(&accel.dev));
+#endif
+	writes = tru_adxl345_shadow_flush(&accel.dev);
+	printf("ADXL345 configured with %u I2C writes\n", writes);
+#if(OPT_ADXL345_WAKE_ON_MOTION == 1)
+	tru_adxl345_pm_init(&accel.pm, &accel.dev, accel.gtim_freq_hz, OPT_ADXL345_WAKEUP, gtim_get_counter());
+#endif
+#if(OPT_ADXL345_FREEFALL == 1)
+	tru_adxl345_ff_init(&accel.ff, accel.gtim_freq_hz, tru_adxl345_rate_to_mhz(OPT_ADXL345_RATE), tru_adxl345_shadow(&accel.dev)->time_ff);
+#endif
+}
 
-#if OPT_ADXL345_TAP_SINGLE_ENABLE == 1 || OPT_ADXL345_TAP_DOUBLE_ENABLE == 1
-	buffer[0] = OPT_ADXL345_TAP_THR;
-	tru_adxl345_i2c_write(buffer, 1, TRU_ADXL345_THRESH_TAP_ADDR);
-	buffer[0] = OPT_ADXL345_TAP_DUR;
-	tru_adxl345_i2c_write(buffer, 1, TRU_ADXL345_DUR_ADDR);
-	buffer[0] = OPT_ADXL345_TAP_LAT;
-	tru_adxl345_i2c_write(buffer, 1, TRU_ADXL345_LATENT_ADDR);
-	buffer[0] = OPT_ADXL345_TAP_WIN;
-	tru_adxl345_i2c_write(buffer, 1, TRU_ADXL345_WINDOW_ADDR);
-
-	TRU_ADXL345_TAP_AXES_PTR(buffer)->val = 0;
-	TRU_ADXL345_TAP_AXES_PTR(buffer)->bits.tap_x_en = OPT_ADXL345_TAP_X_ENABLE;
-	TRU_ADXL345_TAP_AXES_PTR(buffer)->bits.tap_y_en = OPT_ADXL345_TAP_Y_ENABLE;
-	TRU_ADXL345_TAP_AXES_PTR(buffer)->bits.tap_z_en = OPT_ADXL345_TAP_Z_ENABLE;
-	tru_adxl345_i2c_write(buffer, 1, TRU_ADXL345_TAP_AXES_ADDR);
-#endif
-
-	// Set ADXL345 output rate
-	TRU_ADXL345_BW_RATE_PTR(buffer)->val = 0;
-	TRU_ADXL345_BW_RATE_PTR(buffer)->bits.rate = OPT_ADXL345_RATE;
-	tru_adxl345_i2c_write(buffer, 1, TRU_ADXL345_BW_RATE_ADDR);
-
-	// Set ADXL345 data options
-	TRU_ADXL345_DATA_FORMAT_PTR(buffer)->val = 0;
-	TRU_ADXL345_DATA_FORMAT_PTR(buffer)->bits.range = OPT_ADXL345_RANGE;
-	TRU_ADXL345_DATA_FORMAT_PTR(buffer)->bits.fullres = 1;
-	TRU_ADXL345_DATA_FORMAT_PTR(buffer)->bits.intinvert = 1;
-	tru_adxl345_i2c_write(buffer, 1, TRU_ADXL345_DATA_FORMAT_ADDR);
+#if(OPT_ADXL345_SELFTEST > 0)
+// Go/no-go check of the sensor, see tru_adxl345_st.c
+void selftest(void){
+	tru_adxl345_st_result_t result;
+	tru_adxl345_st_stats_t stats;
 
-#if OPT_ADXL345_FIFO_ENABLE == 1
-	// Set ADXL345 FIFO mode
-	TRU_ADXL345_FIFO_CTL_PTR(buffer)->val = 0;
-	TRU_ADXL345_FIFO_CTL_PTR(buffer)->bits.fifomode = TRU_ADXL345_FIFOMODE_STREAM;
-	TRU_ADXL345_FIFO_CTL_PTR(buffer)->bits.samples = OPT_ADXL345_WATERLEVEL;
-	tru_adxl345_i2c_write(buffer, 1, TRU_ADXL345_FIFO_CTL_ADDR);
-#else
-	// Set ADXL345 FIFO mode off
-	TRU_ADXL345_FIFO_CTL_PTR(buffer)->val = 0;
-	TRU_ADXL345_FIFO_CTL_PTR(buffer)->bits.fifomode = TRU_ADXL345_FIFOMODE_BYPASS;
-	TRU_ADXL345_FIFO_CTL_PTR(buffer)->bits.samples = 16;
-	tru_adxl345_i2c_write(buffer, 1, TRU_ADXL345_FIFO_CTL_ADDR);
+	tru_adxl345_st_stats_init(&stats);
+	for(uint32_t i = 0; i < OPT_ADXL345_SELFTEST; i++){
+		tru_adxl345_st_run(&accel.dev, OPT_ADXL345_SELFTEST_SAMPLES, OPT_ADXL345_VS_MV, accel.gtim_freq_hz, &result);
+		tru_adxl345_st_stats_add(&stats, &result);
+		printf("Self-test %s in %u us: x = %i (%i to %i), y = %i (%i to %i), z = %i (%i to %i), fail = 0x%.2x\n", result.pass ? "PASS" : "FAIL", result.time_us, result.delta[0], result.min[0], result.max[0], result.delta[1], result.min[1], result.max[1], result.delta[2], result.min[2], result.max[2], result.fail);
+	}
+#if(OPT_ADXL345_SELFTEST > 1)
+	printf("Self-test passes = %u of %u, axis fails = %u, %u, %u, timeouts = %u, x = %i to %i, y = %i to %i, z = %i to %i, longest = %u us\n", stats.passes, stats.runs, stats.axis_fails[0], stats.axis_fails[1], stats.axis_fails[2], stats.timeouts, stats.delta_min[0], stats.delta_max[0], stats.delta_min[1], stats.delta_max[1], stats.delta_min[2], stats.delta_max[2], stats.time_max_us);
 #endif
+}
+#endif
+
+#if(OPT_ADXL345_CAL_RUN == 1)
+// Sums n samples polled from the data registers
+void cal_sample(tru_adxl345_cal_t *cal, uint32_t n){
+	tru_adxl345_int_source_t int_source;
+	int16_t xyz[3];
 
-	// Set ADXL345 which triggers generate interrupts
-	TRU_ADXL345_INT_ENABLE_PTR(buffer)->val = 0;
-	TRU_ADXL345_INT_ENABLE_PTR(buffer)->bits.watermark = OPT_ADXL345_FIFO_ENABLE;
-	TRU_ADXL345_INT_ENABLE_PTR(buffer)->bits.doubletap = OPT_ADXL345_TAP_DOUBLE_ENABLE;
-	TRU_ADXL345_INT_ENABLE_PTR(buffer)->bits.singletap = OPT_ADXL345_TAP_SINGLE_ENABLE;
-	TRU_ADXL345_INT_ENABLE_PTR(buffer)->bits.dataready = 1;
-	tru_adxl345_i2c_write(buffer, 1, TRU_ADXL345_INT_ENABLE_ADDR);
+	tru_adxl345_cal_reset(cal);
+	while(cal->n < n){
+		tru_adxl345_i2c_read(&accel.dev, &int_source, 1, TRU_ADXL345_INT_SOURCE_ADDR);
+		if(int_source.bits.dataready){
+			tru_adxl345_i2c_read_bm(&accel.dev, xyz, 6, TRU_ADXL345_DATAX0_ADDR);
+			tru_adxl345_cal_add(cal, xyz);
+		}
+	}
+}
+
+// Calibrates the offsets with the board at rest, checks the residual with the
+// new offsets and saves them to the SD card
+void calibrate(void){
+	tru_adxl345_config_t *shadow = tru_adxl345_shadow(&accel.dev);
+	tru_adxl345_config_t saved = *shadow;
+	tru_adxl345_cal_t cal;
+	tru_adxl345_cal_record_t rec;
+	tru_adxl345_cal_record_t old;
+	uint8_t pass = 1;
+
+	printf("Calibrating the offsets, keep the board at rest\n");
+
+	// 100Hz as the datasheet suggests, without the FIFO so the data registers
+	// hold the newest sample.  The first samples let the filter settle
+	shadow->bw_rate.bits.rate = TRU_ADXL345_RATE_100_HZ;
+	shadow->fifo_ctl.bits.fifomode = TRU_ADXL345_FIFOMODE_BYPASS;
+	tru_adxl345_shadow_flush(&accel.dev);
+	tru_adxl345_cal_init(&cal, shadow->data_format, OPT_ADXL345_CAL_UP);
+	cal_sample(&cal, 10);
+
+	cal_sample(&cal, OPT_ADXL345_CAL_SAMPLES);
+	rec.ofs[0] = tru_adxl345_cal_offset(&cal, 0, shadow->ofsx);
+	rec.ofs[1] = tru_adxl345_cal_offset(&cal, 1, shadow->ofsy);
+	rec.ofs[2] = tru_adxl345_cal_offset(&cal, 2, shadow->ofsz);
+	shadow->ofsx = rec.ofs[0];
+	shadow->ofsy = rec.ofs[1];
+	shadow->ofsz = rec.ofs[2];
+	tru_adxl345_shadow_flush(&accel.dev);
 
-	// Set ADXL345 interrupt output on INT1 pin
-	TRU_ADXL345_INT_MAP_PTR(buffer)->val = 0x0;
-	tru_adxl345_i2c_write(buffer, 1, TRU_ADXL345_INT_MAP_ADDR);
+	// What is left with the new offsets
+	cal_sample(&cal, OPT_ADXL345_CAL_SAMPLES);
+	for(uint32_t i = 0; i < 3; i++){
+		rec.residual_ug[i] = tru_adxl345_cal_error_ug(&cal, i);
+		if(rec.residual_ug[i] > TRU_ADXL345_CAL_TOL_UG || rec.residual_ug[i] < -TRU_ADXL345_CAL_TOL_UG) pass = 0;
+	}
+	printf("Offsets: x = %i, y = %i, z = %i, residual = %i, %i, %i ug\n", rec.ofs[0], rec.ofs[1], rec.ofs[2], rec.residual_ug[0], rec.residual_ug[1], rec.residual_ug[2]);
+
+	if(pass){
+		rec.count = cal_read(&old) ? old.count + 1U : 1U;
+		rec.samples = OPT_ADXL345_CAL_SAMPLES;
+		rec.up = OPT_ADXL345_CAL_UP;
+		rec.range = shadow->data_format.bits.range;
+		for(uint32_t i = 0; i < TRU_HPS_SDMMC_BLOCK_SIZE / 4U; i++) cal_block[i] = 0;
+		tru_adxl345_cal_pack(&rec, (uint8_t *)cal_block);
+		if(tru_hps_sdmmc_write_block(OPT_ADXL345_CAL_SD_BLOCK, cal_block) == ALT_E_SUCCESS){
+			printf("Offsets saved to the SD card (calibration %u)\n", rec.count);
+		}else{
+			printf("Offsets not saved, the SD card write failed\n");
+		}
+		saved.ofsx = rec.ofs[0];
+		saved.ofsy = rec.ofs[1];
+		saved.ofsz = rec.ofs[2];
+	}else{
+		printf("Calibration failed, a residual is over %i ug, the board may have moved.  Offsets not changed\n", TRU_ADXL345_CAL_TOL_UG);
+	}
+
+	// Back to the configured rate and FIFO mode, going from bypass also empties
+	// the FIFO
+	*shadow = saved;
+	tru_adxl345_shadow_flush(&accel.dev);
+}
+#endif
 
-	// Set ADXL345 to start measuring
-	TRU_ADXL345_POWER_CTL_PTR(buffer)->val = 0;
-	TRU_ADXL345_POWER_CTL_PTR(buffer)->bits.measure = 1;
-	tru_adxl345_i2c_write(buffer, 1, TRU_ADXL345_POWER_CTL_ADDR);
+#if OPT_I2C_SELFCHECK == 1
+// Theoretical data rate in bytes/s for reading FIFO entries at the given SCL frequency
+// Each 6 byte entry read is 9 bytes on the bus (device address, register address,
+// device address and 6 data), each with an ACK bit, plus the start, restart and stop
+static uint32_t i2c_entry_limit(uint32_t scl_freq_hz){
+	return (uint32_t)((uint64_t)scl_freq_hz * 6 / (9 * 9 + 3));
 }
 
+// Reads back the programmed SCL timing and measures the sample read throughput
+void check_i2c(void){
+	tru_adxl345_i2c_scl_t scl;
+	uint32_t scl_freq_hz;
+	uint64_t ticks;
+
+	scl_freq_hz = tru_adxl345_i2c_scl_readback(&accel.dev, accel.l4_sp_clock_freq_hz, &scl);
+	printf("I2C SCL = %u Hz (SPKLEN = %u, HCNT = %u, LCNT = %u)\n", scl_freq_hz, scl.spklen, scl.hcnt, scl.lcnt);
+	printf("I2C entry read limit = %u bytes/s\n", i2c_entry_limit(scl_freq_hz));
+
+	// One transaction at a time
+	ticks = gtim_get_counter();
+	for(uint32_t i = 0; i < OPT_I2C_SELFCHECK_READS; i++){
+		tru_adxl345_i2c_read_bm(&accel.dev, &accel.sample, 6, TRU_ADXL345_DATAX0_ADDR);
+	}
+	ticks = gtim_get_counter() - ticks;
+	if(ticks){
+		printf("I2C read_bm = %u bytes/s\n", (uint32_t)((uint64_t)OPT_I2C_SELFCHECK_READS * 6 * accel.gtim_freq_hz / ticks));
+	}
+
+	// Pipelined transactions
+	ticks = gtim_get_counter();
+	for(uint32_t i = 0; i < OPT_I2C_SELFCHECK_READS / TRU_ADXL345_FIFO_DEPTH; i++){
+		tru_adxl345_fifo_drain(&accel.dev, fifo_sample, TRU_ADXL345_FIFO_DEPTH);
+	}
+	ticks = gtim_get_counter() - ticks;
+	if(ticks){
+		printf("I2C fifo_drain = %u bytes/s\n", (uint32_t)((uint64_t)(OPT_I2C_SELFCHECK_READS / TRU_ADXL345_FIFO_DEPTH) * TRU_ADXL345_FIFO_DEPTH * 6 * accel.gtim_freq_hz / ticks));
+	}
+}
+#endif
+
+#if OPT_OUTPUT_BENCH_SAMPLES > 0
+// Measures the output rate of each format with test samples.  Both are limited
+// by the UART, so this shows the highest sample rate each format can keep up with
+void bench_output(void){
+	const uint8_t delimiter = 0;
+	tru_telemetry_t tm;
+	uint64_t ticks;
+	uint64_t text_ticks;
+#if(TRU_UART_TX_RING == 1U)
+	tru_hps_uart_tx_stats_t stats;
+#endif
+
+	// Text
+	ticks = gtim_get_counter();
+	for(uint32_t i = 0; i < OPT_OUTPUT_BENCH_SAMPLES; i++){
+		printf("%.10u: x=%-4i y=%-4i z=%-4i\n", i, -256, 256, -4096);
+	}
+	output_wait_empty();
+	text_ticks = gtim_get_counter() - ticks;
+
+	// Binary, flagged as synthetic so the host decoder drops these frames
+	tru_telemetry_init(&tm);
+	ticks = gtim_get_counter();
+	output_write_frame(&delimiter, 1);
+	for(uint32_t i = 0; i < OPT_OUTPUT_BENCH_SAMPLES; i++){
+		tru_telemetry_set_flags(&tm, TRU_TELEMETRY_FLAG_SYNTHETIC);
+		output_write_frame(tm.frame, tru_telemetry_add(&tm, timestamp_us(), -256, 256, -4096));
+	}
+	output_write_frame(tm.frame, tru_telemetry_flush(&tm));
+	output_wait_empty();
+	ticks = gtim_get_counter() - ticks;
+
+	printf("\n");
+	if(text_ticks) printf("Output text = %u samples/s\n", (uint32_t)((uint64_t)OPT_OUTPUT_BENCH_SAMPLES * accel.gtim_freq_hz / text_ticks));
+	if(ticks) printf("Output binary = %u samples/s\n", (uint32_t)((uint64_t)OPT_OUTPUT_BENCH_SAMPLES * accel.gtim_freq_hz / ticks));
+#if(TRU_UART_TX_RING == 1U)
+	tru_hps_uart_tx_get_stats(&stats);
+	printf("UART TX ring high-water = %u bytes, dropped = %u bytes\n", stats.high_water, stats.dropped);
+#endif
+}
+#endif
+
+#if(OPT_IRQ_LATENCY_BENCH > 0)
+static volatile uint8_t bench_armed;
+static volatile uint32_t bench_delay_ticks;
+static volatile uint64_t bench_compare_ticks;
+static volatile uint64_t bench_irq_ticks;
+static volatile uint64_t bench_irq_end_ticks;
+
+// UART interrupt handler while benchmarking, arms the stand-in INT1 to fire
+// while it is busy
+static void bench_uart_irq_handler(void){
+	if(bench_armed){
+		bench_armed = 0;
+		bench_compare_ticks = gtim_get_counter() + bench_delay_ticks;
+#if(TRU_IRQ_STATS == 1U)
+		irq_stats_set_assert(GTIM_IRQN, (uint32_t)bench_compare_ticks);  // Known assert time, for the true latency
+#endif
+		gtim_set_compare(bench_compare_ticks);
+	}
+	tru_hps_uart_tx_irq_handler();
+}
+
+// Stand-in INT1 interrupt handler, integer only like the INT1 top half
+static void IRQ_INT_ONLY(bench_int1_irq_handler) bench_int1_irq_handler(void){
+	bench_irq_ticks = gtim_get_counter();
+	gtim_clear_compare();
+	bench_irq_end_ticks = gtim_get_counter();
+}
+
+// Measures the shortest entry and exit time of the stand-in INT1 with or
+// without the VFP register save, with no other interrupt busy.  Entry is from
+// the compare to the handler start, exit from the handler end to the spinning
+// loop reading the counter again
+static void bench_irq_vfp(uint8_t vfp, uint32_t *entry_min, uint32_t *exit_min){
+	uint32_t margin_ticks = accel.gtim_freq_hz / 1000000U;
+	uint64_t ticks;
+	uint32_t t;
+
+	irq_set_vfp(GTIM_IRQN, vfp);
+	*entry_min = UINT32_MAX;
+	*exit_min = UINT32_MAX;
+	for(uint32_t i = 0; i < OPT_IRQ_LATENCY_BENCH; i++){
+		bench_irq_ticks = 0;
+		bench_compare_ticks = gtim_get_counter() + margin_ticks;
+		gtim_set_compare(bench_compare_ticks);
+		while(bench_irq_ticks == 0);
+		ticks = gtim_get_counter();
+
+		t = (uint32_t)(bench_irq_ticks - bench_compare_ticks);
+		if(t < *entry_min) *entry_min = t;
+		t = (uint32_t)(ticks - bench_irq_end_ticks);
+		if(t < *exit_min) *exit_min = t;
+	}
+}
+
+// Measures the worst case INT1 interrupt latency under UART interrupt load.
+// The global timer compare interrupt stands in for INT1 at its priority and
+// as IRQ or FIQ, because its time is known: the UART interrupt handler arms
+// it to fire a little after the handler starts, and the latency is from then
+// to the handler entry.  As an IRQ without TRU_IRQ_NESTED it waits for the
+// UART handler to finish.  Before that, the entry and exit times with and
+// without the VFP register save are measured with the UART idle
+void bench_irq_latency(void){
+	uint32_t margin_ticks = accel.gtim_freq_hz / 1000000U;  // 1us, so the compare is not already behind the counter
+	uint32_t window_ticks = accel.gtim_freq_hz / 50000U;    // Spread the firing over the first 20us of the UART handler
+	uint32_t t;
+	uint32_t min = UINT32_MAX;
+	uint32_t max = 0;
+	uint64_t sum = 0;
+	uint32_t entry_vfp, exit_vfp, entry_int, exit_int;
+
+	IRQ_SetHandler(GTIM_IRQN, bench_int1_irq_handler);
+	IRQ_SetPriority(GTIM_IRQN, INT1_IRQ_PRIORITY);
+#if(OPT_ADXL345_INT1_FIQ == 1)
+	irq_route_fiq(GTIM_IRQN);  // Same path as INT1
+#endif
+	IRQ_Enable(GTIM_IRQN);
+
+	output_wait_empty();
+	bench_irq_vfp(0, &entry_int, &exit_int);
+	bench_irq_vfp(1, &entry_vfp, &exit_vfp);  // Left on for the load test, as before
+	IRQ_SetHandler(C5SOC_UART0_IRQn, bench_uart_irq_handler);
+
+	for(uint32_t i = 0; i < OPT_IRQ_LATENCY_BENCH; i++){
+		// Keep the UART interrupt busy
+		while(tru_hps_uart_tx_used() < TRU_UART_TX_SIZE / 2U){
+			printf("%.10u: IRQ latency load\n", i);
+		}
+
+		bench_irq_ticks = 0;
+		bench_delay_ticks = margin_ticks + (i * 7919U) % window_ticks;
+		bench_armed = 1;
+		while(bench_irq_ticks == 0);
+
+		t = (uint32_t)(bench_irq_ticks - bench_compare_ticks);
+		if(t < min) min = t;
+		if(t > max) max = t;
+		sum += t;
+	}
+
+	IRQ_SetHandler(C5SOC_UART0_IRQn, tru_hps_uart_tx_irq_handler);
+	IRQ_Disable(GTIM_IRQN);
+	IRQ_SetHandler(GTIM_IRQN, (IRQHandler_t)0);
+	output_wait_empty();
+
+	printf("\n");
+	printf("INT1 %s entry/exit with VFP save = %u/%u ns, integer only = %u/%u ns\n", OPT_ADXL345_INT1_FIQ ? "FIQ" : (TRU_IRQ_NESTED ? "nested IRQ" : "IRQ"), (uint32_t)((uint64_t)entry_vfp * 1000000000U / accel.gtim_freq_hz), (uint32_t)((uint64_t)exit_vfp * 1000000000U / accel.gtim_freq_hz), (uint32_t)((uint64_t)entry_int * 1000000000U / accel.gtim_freq_hz), (uint32_t)((uint64_t)exit_int * 1000000000U / accel.gtim_freq_hz));
+	printf("INT1 %s latency under UART load = %u to %u ns (jitter = %u ns), mean = %u ns\n", OPT_ADXL345_INT1_FIQ ? "FIQ" : (TRU_IRQ_NESTED ? "nested IRQ" : "IRQ"), (uint32_t)((uint64_t)min * 1000000000U / accel.gtim_freq_hz), (uint32_t)((uint64_t)max * 1000000000U / accel.gtim_freq_hz), (uint32_t)((uint64_t)(max - min) * 1000000000U / accel.gtim_freq_hz), (uint32_t)(sum * 1000000000U / OPT_IRQ_LATENCY_BENCH / accel.gtim_freq_hz));
+}
+#endif
+
 // Polling read method
 void poll_read(void){
 	tru_adxl345_int_source_t int_source;
+	uint64_t ticks;
+#if OPT_ADXL345_FIFO_ENABLE == 1
+	uint8_t entries;
+#endif
 
 	while(1){
 		int_source.val = 0;
 
+#if OPT_ADXL345_POLL_WAIT == 1
+		// Nothing to read before the next samples are due
+		while(gtim_get_counter() < tru_adxl345_ts_poll_time(&accel.ts, accel.watermark));
+#endif
+
 #if OPT_ADXL345_FIFO_ENABLE == 1
 		// Get current number of sample entries in the FIFO
 		do
-			tru_adxl345_i2c_read(buffer, 1, TRU_ADXL345_FIFO_STATUS_ADDR);
-		while(TRU_ADXL345_FIFO_STATUS_PTR(buffer)->bits.entries < OPT_ADXL345_WATERLEVEL);
+			tru_adxl345_i2c_read(&accel.dev, buffer, 1, TRU_ADXL345_FIFO_STATUS_ADDR);
+		while(TRU_ADXL345_FIFO_STATUS_PTR(buffer)->bits.entries < accel.watermark);
+		ticks = gtim_get_counter();
 		//printf("ADXL345 FIFO entries = %u\n", TRU_ADXL345_FIFO_STATUS_PTR(buffer)->bits.entries);
 
 		// Read interrupt triggers
-		tru_adxl345_i2c_read(&int_source, 1, TRU_ADXL345_INT_SOURCE_ADDR);
+		tru_adxl345_i2c_read(&accel.dev, &int_source, 1, TRU_ADXL345_INT_SOURCE_ADDR);
 
-		if(int_source.bits.singletap && int_source.bits.doubletap){
-			printf("%.10u: TAPPED + DOUBLE\n", accel.sample_count);
-		}else if(int_source.bits.singletap){
-			printf("%.10u: TAPPED\n", accel.sample_count);
-		}
+		output_tap(int_source);
 
 		// Read out samples from ADXL345 FIFO
-		for(uint8_t i = 0; i < TRU_ADXL345_FIFO_STATUS_PTR(buffer)->bits.entries; i++){
-			tru_adxl345_i2c_read_bm(&accel.sample, 6, TRU_ADXL345_DATAX0_ADDR);
-			printf("%.10u: x=%-4i y=%-4i z=%-4i\n", accel.sample_count, accel.sample.x, accel.sample.y, accel.sample.z);
-			accel.sample_count++;
-		}
+		entries = TRU_ADXL345_FIFO_STATUS_PTR(buffer)->bits.entries;
+		if(entries > TRU_ADXL345_FIFO_DEPTH) entries = TRU_ADXL345_FIFO_DEPTH;
+		tru_adxl345_fifo_drain(&accel.dev, fifo_sample, entries);
+		output_drain(fifo_sample, entries, ticks, int_source);
 #else
 		// Wait for data available
 		do{
-			tru_adxl345_i2c_read(buffer, 1, TRU_ADXL345_INT_SOURCE_ADDR);
+			tru_adxl345_i2c_read(&accel.dev, buffer, 1, TRU_ADXL345_INT_SOURCE_ADDR);
 			int_source.val |= buffer[0];
 		}while(int_source.bits.dataready == 0);
+		ticks = gtim_get_counter();
 
-		if(int_source.bits.singletap && int_source.bits.doubletap){
-			printf("%.10u: TAPPED + DOUBLE\n", accel.sample_count);
-		}else if(int_source.bits.singletap){
-			printf("%.10u: TAPPED\n", accel.sample_count);
-		}
+		output_tap(int_source);
 
 		// Read out samples
-		tru_adxl345_i2c_read_bm(&accel.sample, 6, TRU_ADXL345_DATAX0_ADDR);
-		printf("%.10u: x=%-4i y=%-4i z=%-4i\n", accel.sample_count, accel.sample.x, accel.sample.y, accel.sample.z);
-		accel.sample_count++;
+		tru_adxl345_i2c_read_bm(&accel.dev, &accel.sample, 6, TRU_ADXL345_DATAX0_ADDR);
+		output_drain(&accel.sample, 1, ticks, int_source);
 #endif
 	}
 }
 
-// Interrupt handler for the ADXL345 INT1 pin
+#if(OPT_ADXL345_MULTI == 1)
+// Extra ADXL345 sensors, read in turn with the on-board one.  The entry below
+// is a second sensor on I2C0 with SDO/ALT ADDRESS pulled high.  They must all
+// be fitted, the blocking reads wait forever on a device that doesn't answer
+const struct{
+	uint32_t i2c_base;
+	uint16_t addr;
+}multi_sensor[] = {
+	{ TRU_HPS_I2C0_BASE, TRU_ADXL345_I2C_ALT_DEV_ADDR },
+};
+
+#define MULTI_EXTRA (sizeof(multi_sensor) / sizeof(multi_sensor[0]))
+
+tru_adxl345_dev_t multi_dev[MULTI_EXTRA];
+tru_adxl345_sched_t sched;
+
+#if(OPT_ADXL345_TS_REPORT > 0)
+// Sample throughput of each I2C controller in use
+void report_multi(void){
+	const uint32_t i2c_base[TRU_ADXL345_I2C_BUSES] = { TRU_HPS_I2C0_BASE, TRU_HPS_I2C1_BASE, TRU_HPS_I2C2_BASE, TRU_HPS_I2C3_BASE };
+	tru_adxl345_sched_bus_stats_t stats;
+
+	for(uint32_t i = 0; i < TRU_ADXL345_I2C_BUSES; i++){
+		tru_adxl345_sched_get_bus_stats(&sched, i2c_base[i], &stats);
+		if(stats.sensors == 0) continue;
+		printf("I2C%u: sensors = %u, samples = %u (%u samples/s), FIFO polls = %u, address switches = %u\n", i, stats.sensors, stats.samples, stats.samples_hz, stats.polls, stats.tar_switches);
+	}
+}
+#endif
+
+// Outputs a drain of sensor index, each line starts with the sensor index
+static void multi_drain(tru_adxl345_sched_t *sched, uint32_t index, const void *buf, uint32_t n, tru_adxl345_int_source_t int_source){
+	tru_adxl345_sched_sensor_t *s = &sched->sensor[index];
+	const tru_adxl345_data *sample = buf;
+	uint32_t lost = s->ts.gap;
+	uint32_t count = s->samples + lost;
+
+	if(lost){
+		printf("[%u] %.10u: t=%.10u GAP lost=%u\n", index, s->samples, (uint32_t)tru_adxl345_ts_to_us(&s->ts, tru_adxl345_ts_sample(&s->ts, n + lost, 0)), lost);
+	}
+	if(int_source.bits.singletap){
+		printf("[%u] %.10u: TAPPED%s\n", index, count, int_source.bits.doubletap ? " + DOUBLE" : "");
+	}
+	for(uint32_t i = 0; i < n; i++){
+		printf("[%u] %.10u: t=%.10u x=%-4i y=%-4i z=%-4i\n", index, count + i, (uint32_t)tru_adxl345_ts_to_us(&s->ts, tru_adxl345_ts_sample(&s->ts, n, i)), sample[i].x, sample[i].y, sample[i].z);
+	}
+
+#if(OPT_ADXL345_TS_REPORT > 0)
+	if(index == 0 && s->drains % OPT_ADXL345_TS_REPORT == 0) report_multi();
+#endif
+}
+
+// Sets up the extra sensors with the same configuration as the on-board one,
+// and the scheduler with all of them
+void setup_multi(void){
+	tru_adxl345_dev_t *dev;
+	uint8_t bus_ready;
+	uint32_t writes;
+
+	tru_adxl345_sched_init(&sched, accel.gtim_freq_hz, multi_drain);
+	tru_adxl345_sched_add(&sched, &accel.dev, tru_adxl345_rate_to_mhz(OPT_ADXL345_RATE), accel.watermark);
+
+	for(uint32_t i = 0; i < MULTI_EXTRA; i++){
+		dev = &multi_dev[i];
+		tru_adxl345_dev_init(dev, multi_sensor[i].i2c_base, multi_sensor[i].addr);
+
+		// A controller is set up once, by its first sensor
+		bus_ready = (dev->i2c_base == accel.dev.i2c_base);
+		for(uint32_t j = 0; j < i; j++){
+			if(multi_dev[j].i2c_base == dev->i2c_base) bus_ready = 1;
+		}
+		if(!bus_ready) tru_adxl345_i2c_init(dev, accel.l4_sp_clock_freq_hz, TRU_ADXL345_I2C_SPEED_KHZ);
+
+		tru_adxl345_i2c_read(dev, buffer, 1, TRU_ADXL345_DEVID_ADDR);
+		printf("Sensor %u (0x%.2x) device ID: 0x%.2x\n", i + 1U, dev->addr, buffer[0]);
+
+		tru_adxl345_i2c_stop_flush_fifo(dev);
+		tru_adxl345_shadow_load(dev);
+		config_from_options(tru_adxl345_shadow(dev));
+		writes = tru_adxl345_shadow_flush(dev);
+		printf("Sensor %u configured with %u I2C writes\n", i + 1U, writes);
+
+		tru_adxl345_sched_add(&sched, dev, tru_adxl345_rate_to_mhz(OPT_ADXL345_RATE), accel.watermark);
+	}
+}
+
+// Round-robin polling read method
+void multi_read(void){
+	while(1) tru_adxl345_sched_poll(&sched);
+}
+#endif
+
+#if(OPT_ADXL345_I2C_ASYNC == 1)
+// Transactions and buffers for the non-blocking readout.  The GPIO2 interrupt
+// only queues the first transactions, the rest is chained from the I2C0
+// interrupt callbacks while the CPU is free
+tru_adxl345_i2c_xfer_t xfer_int_source;
+tru_adxl345_i2c_xfer_t xfer_fifo_status;
+tru_adxl345_i2c_xfer_t xfer_sample[TRU_ADXL345_FIFO_DEPTH];
+tru_adxl345_int_source_t async_int_source;
+tru_adxl345_fifo_status_t async_fifo_status;
+tru_adxl345_data async_sample[TRU_ADXL345_FIFO_DEPTH];
+uint64_t async_ticks;
+#if(OPT_ADXL345_BUDGET_REPORT > 0)
+uint64_t async_irq_ticks;  // Start of the I2C0 handler time not yet added to the budget
+#endif
+
+// Last sample read, print them and re-enable the INT1 interrupt
+static void async_samples_done(tru_adxl345_i2c_xfer_t *xfer){
+	uint32_t n = (uintptr_t)xfer->context;
+#if(OPT_ADXL345_BUDGET_REPORT > 0)
+	uint64_t output_ticks = gtim_get_counter();
+	uint32_t out_bytes = accel.out_bytes;
+#endif
+
+	output_drain_start(n, async_ticks, async_int_source);
+	for(uint32_t i = 0; i < n; i++){
+		if(xfer_sample[i].status == TRU_ADXL345_I2C_XFER_STATUS_DONE){
+			output_sample(&async_sample[i], sample_us(n, i));
+		}else{
+			accel.sample_count++;
+		}
+	}
+	output_flush();
+#if(OPT_ADXL345_BUDGET_REPORT > 0)
+	// The output is counted by the budget itself, so only add the handler time before it
+	accel.budget_irq_ticks += (uint32_t)(output_ticks - async_irq_ticks);
+	budget_drain(n, 0, output_ticks, out_bytes);
+	async_irq_ticks = gtim_get_counter();
+#endif
+#if(OPT_ADXL345_WM_ADAPT == 1)
+	adapt_watermark(n, async_ticks);
+#endif
+
+	tru_hps_gpio2_ll_int_enable(DE10N_ADXL345_INT1_GPIO_PINNUM);
+}
+
+// Queue the sample reads, all of them are pushed back-to-back by the engine
+static void async_read_samples(uint32_t n){
+	if(n > TRU_ADXL345_FIFO_DEPTH) n = TRU_ADXL345_FIFO_DEPTH;
+	if(n == 0){
+		tru_hps_gpio2_ll_int_enable(DE10N_ADXL345_INT1_GPIO_PINNUM);
+		return;
+	}
+
+	for(uint32_t i = 0; i < n; i++){
+		xfer_sample[i].dir = TRU_ADXL345_I2C_XFER_READ;
+		xfer_sample[i].reg_addr = TRU_ADXL345_DATAX0_ADDR;
+		xfer_sample[i].len = 6;
+		xfer_sample[i].buf = (uint8_t *)&async_sample[i];
+		xfer_sample[i].callback = (i == n - 1) ? async_samples_done : 0;
+		xfer_sample[i].context = (void *)(uintptr_t)n;
+		tru_adxl345_i2c_async_submit(&xfer_sample[i]);
+	}
+}
+
+static void async_fifo_status_done(tru_adxl345_i2c_xfer_t *xfer){
+	if(xfer->status != TRU_ADXL345_I2C_XFER_STATUS_DONE){
+		tru_hps_gpio2_ll_int_enable(DE10N_ADXL345_INT1_GPIO_PINNUM);
+		return;
+	}
+	async_read_samples(async_fifo_status.bits.entries);
+}
+
+static void async_int_source_done(tru_adxl345_i2c_xfer_t *xfer){
+	if(xfer->status != TRU_ADXL345_I2C_XFER_STATUS_DONE){
+		tru_hps_gpio2_ll_int_enable(DE10N_ADXL345_INT1_GPIO_PINNUM);
+		return;
+	}
+
+	output_tap(async_int_source);
+
+#if OPT_ADXL345_FIFO_ENABLE == 1
+	if(async_int_source.bits.watermark == 1){
+		// Get current number of sample entries in the FIFO
+		xfer_fifo_status.dir = TRU_ADXL345_I2C_XFER_READ;
+		xfer_fifo_status.reg_addr = TRU_ADXL345_FIFO_STATUS_ADDR;
+		xfer_fifo_status.len = 1;
+		xfer_fifo_status.buf = &async_fifo_status.val;
+		xfer_fifo_status.callback = async_fifo_status_done;
+		tru_adxl345_i2c_async_submit(&xfer_fifo_status);
+		return;
+	}
+#else
+	if(async_int_source.bits.dataready == 1){
+		async_read_samples(1);
+		return;
+	}
+#endif
+
+	tru_hps_gpio2_ll_int_enable(DE10N_ADXL345_INT1_GPIO_PINNUM);
+}
+
+// Interrupt handler for the ADXL345 INT1 pin, non-blocking version
+static void gpio2_irq_handler(void){
+	async_ticks = gtim_get_counter();
+
+	// INT1 is level triggered, so keep it off until the readout has cleared it
+	tru_hps_gpio2_ll_int_disable(DE10N_ADXL345_INT1_GPIO_PINNUM);
+
+	// Read interrupt triggers
+	xfer_int_source.dir = TRU_ADXL345_I2C_XFER_READ;
+	xfer_int_source.reg_addr = TRU_ADXL345_INT_SOURCE_ADDR;
+	xfer_int_source.len = 1;
+	xfer_int_source.buf = &async_int_source.val;
+	xfer_int_source.callback = async_int_source_done;
+	tru_adxl345_i2c_async_submit(&xfer_int_source);
+#if(OPT_ADXL345_BUDGET_REPORT > 0)
+	accel.budget_irq_ticks += (uint32_t)(gtim_get_counter() - async_ticks);
+#endif
+}
+
+#if(OPT_ADXL345_BUDGET_REPORT > 0)
+// Transaction engine handler with its time added to the budget CPU wait
+static void i2c_async_irq_handler(void){
+	async_irq_ticks = gtim_get_counter();
+	tru_adxl345_i2c_async_irq_handler();
+	accel.budget_irq_ticks += (uint32_t)(gtim_get_counter() - async_irq_ticks);
+}
+#endif
+
+// Setup the I2C0 interrupt for the non-blocking transactions
+void setup_i2c_async(void){
+	tru_adxl345_i2c_async_init();
+
+#if(OPT_ADXL345_BUDGET_REPORT > 0)
+	IRQ_SetHandler(C5SOC_I2C0_IRQ_IRQn, i2c_async_irq_handler);  // Register the transaction engine handler
+#else
+	IRQ_SetHandler(C5SOC_I2C0_IRQ_IRQn, tru_adxl345_i2c_async_irq_handler);  // Register the transaction engine handler
+#endif
+	IRQ_SetPriority(C5SOC_I2C0_IRQ_IRQn, GIC_IRQ_PRIORITY_LEVEL28_0);
+	IRQ_SetMode(C5SOC_I2C0_IRQ_IRQn, IRQ_MODE_TYPE_IRQ | IRQ_MODE_CPU_0 | IRQ_MODE_TRIG_LEVEL | IRQ_MODE_TRIG_LEVEL_HIGH);
+	IRQ_Enable(C5SOC_I2C0_IRQ_IRQn);  // Enable the interrupt
+}
+#elif(OPT_ADXL345_I2C_DMA == 1)
+// Sample buffer written by the DMA controller
+uint8_t dma_buf[TRU_ADXL345_DMA_BUF_SIZE(TRU_ADXL345_FIFO_DEPTH)] __attribute__((aligned(TRU_ADXL345_DMA_BUF_ALIGN)));
+
+uint64_t dma_ticks;
+tru_adxl345_int_source_t dma_int_source;
+
+// DMA drain finished, print the samples and re-enable the INT1 interrupt
+static void dma_drain_done(void *buf, uint32_t n){
+	output_drain(buf, n, dma_ticks, dma_int_source);
+
+	tru_hps_gpio2_ll_int_enable(DE10N_ADXL345_INT1_GPIO_PINNUM);
+}
+
+// Interrupt handler for the ADXL345 INT1 pin, DMA version
 static void gpio2_irq_handler(void){
 	tru_adxl345_int_source_t int_source;
 
+	dma_ticks = gtim_get_counter();
+
 	// Read interrupt triggers
-	tru_adxl345_i2c_read(&int_source, 1, TRU_ADXL345_INT_SOURCE_ADDR);
+	tru_adxl345_i2c_read(&accel.dev, &int_source, 1, TRU_ADXL345_INT_SOURCE_ADDR);
 
-	if(int_source.bits.singletap && int_source.bits.doubletap){
-		printf("%.10u: TAPPED + DOUBLE\n", accel.sample_count);
-	}else if(int_source.bits.singletap){
-		printf("%.10u: TAPPED\n", accel.sample_count);
+	output_tap(int_source);
+
+	if(int_source.bits.watermark == 1){
+		// Get current number of sample entries in the FIFO
+		tru_adxl345_i2c_read(&accel.dev, buffer, 1, TRU_ADXL345_FIFO_STATUS_ADDR);
+
+		// INT1 is level triggered, so keep it off until the DMA has drained the FIFO
+		if(TRU_ADXL345_FIFO_STATUS_PTR(buffer)->bits.entries){
+			tru_hps_gpio2_ll_int_disable(DE10N_ADXL345_INT1_GPIO_PINNUM);
+			dma_int_source = int_source;
+			if(tru_adxl345_dma_fifo_drain(dma_buf, TRU_ADXL345_FIFO_STATUS_PTR(buffer)->bits.entries, dma_drain_done) != ALT_E_SUCCESS){
+				tru_hps_gpio2_ll_int_enable(DE10N_ADXL345_INT1_GPIO_PINNUM);
+			}
+		}
+	}
+#if(OPT_ADXL345_BUDGET_REPORT > 0)
+	accel.budget_irq_ticks += (uint32_t)(gtim_get_counter() - dma_ticks);
+#endif
+}
+
+// Setup the DMA controller and its event interrupt
+void setup_i2c_dma(void){
+	if(tru_adxl345_dma_init(DMA_CHANNEL_I2C_TX, DMA_CHANNEL_I2C_RX, ALT_DMA_EVENT_0) != ALT_E_SUCCESS){
+		printf("Error: DMA init failed\n");
+		return;
+	}
+
+	IRQ_SetHandler(C5SOC_DMA0_IRQn, tru_adxl345_dma_irq_handler);  // Register the DMA event handler
+	IRQ_SetPriority(C5SOC_DMA0_IRQn, GIC_IRQ_PRIORITY_LEVEL28_0);
+	IRQ_SetMode(C5SOC_DMA0_IRQn, IRQ_MODE_TYPE_IRQ | IRQ_MODE_CPU_0 | IRQ_MODE_TRIG_LEVEL | IRQ_MODE_TRIG_LEVEL_HIGH);
+	IRQ_Enable(C5SOC_DMA0_IRQn);  // Enable the interrupt
+}
+#elif(OPT_ADXL345_EVENT_CAPTURE == 1)
+tru_adxl345_event_cap_t event_cap;
+
+// Output an event record, the samples around the trigger oldest first
+void output_event(const tru_adxl345_event_t *event){
+	const tru_adxl345_data *sample = (const tru_adxl345_data *)event->sample;
+
+#if OPT_OUTPUT_BINARY == 0
+	printf("%.10u: t=%.10u EVENT %u pre=%u post=%u%s%s%s\n", accel.sample_count, (uint32_t)tru_adxl345_ts_to_us(&accel.ts, event->trigger_ticks), event->seq, event->pre, event->n - event->pre, event->int_source.bits.singletap ? " TAP" : "", event->int_source.bits.doubletap ? " DOUBLE" : "", event->int_source.bits.activity ? " ACTIVITY" : "");
+#endif
+	output_tap(event->int_source);
+	for(uint32_t i = 0; i < event->n; i++){
+		output_sample(&sample[i], (uint32_t)tru_adxl345_ts_to_us(&accel.ts, tru_adxl345_event_sample_ticks(event, i)));
+	}
+	output_flush();
+}
+
+// Interrupt handler for the ADXL345 INT1 pin, event capture version
+static void gpio2_irq_handler(void){
+	tru_adxl345_int_source_t int_source;
+	tru_adxl345_event_t *event = tru_adxl345_event_irq(&event_cap, gtim_get_counter(), &int_source);
+
+	if(event) output_event(event);
+}
+
+// Arm the FIFO trigger on the enabled taps and activity
+void setup_event(void){
+	tru_adxl345_int_source_t trigger = { .val = 0 };
+
+	trigger.bits.singletap = OPT_ADXL345_TAP_SINGLE_ENABLE;
+	trigger.bits.doubletap = OPT_ADXL345_TAP_DOUBLE_ENABLE;
+	trigger.bits.activity = OPT_ADXL345_EVENT_ACTIVITY;
+	tru_adxl345_event_init(&event_cap, &accel.dev, accel.gtim_freq_hz, tru_adxl345_rate_to_mhz(OPT_ADXL345_RATE), OPT_ADXL345_EVENT_PRE, OPT_ADXL345_EVENT_POST, trigger.val);
+	tru_adxl345_event_arm(&event_cap);
+}
+#else
+#if(OPT_ADXL345_WAKE_ON_MOTION == 1)
+// Follows the ADXL345 in and out of sleep, see tru_adxl345_pm.c
+static void wake_on_motion(tru_adxl345_int_source_t int_source, uint64_t ticks){
+	switch(tru_adxl345_pm_irq(&accel.pm, ticks, int_source)){
+		case TRU_ADXL345_PM_SLEPT:
+#if OPT_OUTPUT_BINARY == 0
+			printf("%.10u: SLEEP\n", accel.sample_count);
+#endif
+			break;
+		case TRU_ADXL345_PM_WOKE:
+			// The samples stopped while asleep
+			tru_adxl345_ts_resume(&accel.ts);
+			break;
 	}
+}
+
+// Measures the wake-up latency on the first drain after a wake-up
+static void wake_latency(uint32_t n){
+	uint32_t latency_us;
 
+	if(tru_adxl345_pm_sample(&accel.pm, tru_adxl345_ts_sample(&accel.ts, n, 0), &latency_us)){
+#if OPT_OUTPUT_BINARY == 0
+		printf("%.10u: WAKE latency=%u us\n", accel.sample_count - n, latency_us);
+#endif
+	}
+}
+#endif
+
+// Reads and outputs whatever raised INT1, ticks is when it was raised
+static void int1_readout(uint64_t ticks){
+	tru_adxl345_int_source_t int_source;
+#if OPT_ADXL345_FIFO_ENABLE == 1
+	uint8_t entries;
+#endif
+
+	// Read interrupt triggers
+	tru_adxl345_i2c_read(&accel.dev, &int_source, 1, TRU_ADXL345_INT_SOURCE_ADDR);
+
+#if(OPT_ADXL345_FREEFALL == 1)
+	// First, before the taps and the FIFO drain
+	if(int_source.bits.freefall) output_freefall(ticks, gtim_get_counter());
+#endif
+	output_tap(int_source);
+
+#if(OPT_ADXL345_WAKE_ON_MOTION == 1)
+	// Asleep, the FIFO only holds samples at the wakeup rate
+	if(accel.pm.asleep) int_source.bits.watermark = 0;
+#endif
 #if OPT_ADXL345_FIFO_ENABLE == 1
 	if(int_source.bits.watermark == 1){
 		// Get current number of sample entries in the FIFO
-		tru_adxl345_i2c_read(buffer, 1, TRU_ADXL345_FIFO_STATUS_ADDR);
+		tru_adxl345_i2c_read(&accel.dev, buffer, 1, TRU_ADXL345_FIFO_STATUS_ADDR);
 		//printf("ADXL345 FIFO entries = %u\n", TRU_ADXL345_FIFO_STATUS_PTR(buffer)->bits.entries);
 
 		// Read out samples from ADXL345 FIFO
-		for(uint8_t i = 0; i < TRU_ADXL345_FIFO_STATUS_PTR(buffer)->bits.entries; i++){
-			tru_adxl345_i2c_read_bm(&accel.sample, 6, TRU_ADXL345_DATAX0_ADDR);
-			printf("%.10u: x=%-4i, y=%-4i, z=%-4i\n", accel.sample_count, accel.sample.x, accel.sample.y, accel.sample.z);
-			accel.sample_count++;
-		}
+		entries = TRU_ADXL345_FIFO_STATUS_PTR(buffer)->bits.entries;
+		if(entries > TRU_ADXL345_FIFO_DEPTH) entries = TRU_ADXL345_FIFO_DEPTH;
+		tru_adxl345_fifo_drain(&accel.dev, fifo_sample, entries);
+		output_drain(fifo_sample, entries, ticks, int_source);
+#if(OPT_ADXL345_WAKE_ON_MOTION == 1)
+		wake_latency(entries);
+#endif
 	}
 #else
 	if(int_source.bits.dataready == 1){
 		// Read out samples
-		tru_adxl345_i2c_read_bm(&accel.sample, 6, TRU_ADXL345_DATAX0_ADDR);
-		printf("%.10u: x=%-4i, y=%-4i, z=%-4i\n", accel.sample_count, accel.sample.x, accel.sample.y, accel.sample.z);
-		accel.sample_count++;
+		tru_adxl345_i2c_read_bm(&accel.dev, &accel.sample, 6, TRU_ADXL345_DATAX0_ADDR);
+		output_drain(&accel.sample, 1, ticks, int_source);
 	}
 #endif
+#if(OPT_ADXL345_WAKE_ON_MOTION == 1)
+	wake_on_motion(int_source, ticks);
+#endif
+}
+
+// Adds a handler run to the IRQs masked time
+static void IRQ_INT_ONLY(int1_irq_time) int1_irq_time(uint64_t ticks){
+	uint32_t t = (uint32_t)(gtim_get_counter() - ticks);
+
+	accel.irq_count++;
+	accel.irq_sum_ticks += t;
+	if(t > accel.irq_max_ticks) accel.irq_max_ticks = t;
+}
+
+#if(OPT_ADXL345_INT1_DEFER == 1)
+// Bottom half, runs from the main loop with IRQs enabled
+static void int1_bottom_half(uint32_t arg, uint64_t ticks){
+	(void)arg;
+
+	int1_readout(ticks);
+	tru_hps_gpio2_ll_int_enable(DE10N_ADXL345_INT1_GPIO_PINNUM);
+}
+
+// Interrupt handler for the ADXL345 INT1 pin, top half.  With
+// OPT_ADXL345_INT1_FIQ it is the FIQ handler.  Integer only, see irq_set_vfp()
+static void IRQ_INT_ONLY(gpio2_irq_handler) gpio2_irq_handler(void){
+	uint64_t ticks = gtim_get_counter();
+
+	// INT1 is level triggered, so keep it off until the bottom half has cleared
+	// it.  This also means there is never more than one post to the queue
+	tru_hps_gpio2_ll_int_disable(DE10N_ADXL345_INT1_GPIO_PINNUM);
+	tru_defer_post(int1_bottom_half, 0, ticks);
+	int1_irq_time(ticks);
+}
+#else
+// Interrupt handler for the ADXL345 INT1 pin, does all the readout
+static void gpio2_irq_handler(void){
+	uint64_t ticks = gtim_get_counter();
+
+	int1_readout(ticks);
+	int1_irq_time(ticks);
 }
+#endif
+
+#endif
 
 // Setup ADXL345 INT1 pin
 void setup_adxl345_int1_pin(void){
@@ -283,20 +1612,90 @@ void setup_adxl345_int1_pin(void){
 
 	irq_mask(0);  // Enable IRQ mode interrupts for this CPU
 	IRQ_SetHandler(C5SOC_GPIO2_IRQn, gpio2_irq_handler);  // Register user interrupt handler
-	IRQ_SetPriority(C5SOC_GPIO2_IRQn, GIC_IRQ_PRIORITY_LEVEL29_7);  // Set lowest usable priority
+#if(OPT_ADXL345_INT1_DEFER == 1 && OPT_ADXL345_I2C_ASYNC == 0 && OPT_ADXL345_I2C_DMA == 0 && OPT_ADXL345_EVENT_CAPTURE == 0)
+	irq_set_vfp(C5SOC_GPIO2_IRQn, 0);  // The top half is integer only, skip saving the VFP registers
+#endif
+	IRQ_SetPriority(C5SOC_GPIO2_IRQn, INT1_IRQ_PRIORITY);
 	IRQ_SetMode(C5SOC_GPIO2_IRQn, IRQ_MODE_TYPE_IRQ | IRQ_MODE_CPU_0 | IRQ_MODE_TRIG_LEVEL | IRQ_MODE_TRIG_LEVEL_HIGH);
+#if(OPT_ADXL345_INT1_FIQ == 1)
+	irq_route_fiq(C5SOC_GPIO2_IRQn);  // Signal it as the FIQ instead
+#endif
 	IRQ_Enable(C5SOC_GPIO2_IRQn);  // Enable the interrupt
 }
 
 int main(void){
+#if(TRU_UART_TX_RING == 1U)
+	setup_uart_tx();
+#endif
 	printf("ADXL345 accelerometer example\n");
 
+	// Get the L4 Slave Peripheral clock frequency, it clocks the UART and I2C controllers
+	alt_clk_freq_get(ALT_CLK_L4_SP, &accel.l4_sp_clock_freq_hz);
+	//printf("L4_SP_CLK = %u Hz\n", accel.l4_sp_clock_freq_hz);
+
+	setup_timer();
+#if(OPT_UART_BAUD > 0)
+	setup_uart_baud();
+#endif
+#if(OPT_ADXL345_I2C_DMA == 1 || OPT_OUTPUT_UART_DMA == 1)
+	setup_dma();
+#endif
+#if(OPT_OUTPUT_UART_DMA == 1)
+	setup_uart_dma();
+#endif
+#if(OPT_ADXL345_CAL_LOAD == 1 || OPT_ADXL345_CAL_RUN == 1)
+	setup_sdmmc();
+#endif
 	setup_adxl345();
+#if(OPT_ADXL345_SELFTEST > 0)
+	selftest();
+#endif
+#if(OPT_ADXL345_CAL_RUN == 1)
+	calibrate();
+#endif
+#if(OPT_ADXL345_MULTI == 1)
+	setup_multi();
+#endif
+#if OPT_I2C_SELFCHECK == 1
+	check_i2c();
+#endif
+#if OPT_OUTPUT_BENCH_SAMPLES > 0
+	bench_output();
+#endif
+#if(OPT_IRQ_LATENCY_BENCH > 0)
+	bench_irq_latency();
+#endif
+	output_start();
+#if(OPT_ADXL345_BUDGET_REPORT > 0)
+	budget_start();
+#endif
 
 	// Use interrupt? else poll
 #if(OPT_ADXL345_INT1_ENABLE == 1)
+#if(OPT_ADXL345_I2C_ASYNC == 1)
+	setup_i2c_async();
+	setup_adxl345_int1_pin();
+	while(1) __WFI();  // Sleep, the readout runs from interrupts
+#elif(OPT_ADXL345_I2C_DMA == 1)
+	setup_i2c_dma();
 	setup_adxl345_int1_pin();
-	while(1);
+	while(1) __WFI();  // Sleep, the readout runs from DMA and interrupts
+#elif(OPT_ADXL345_EVENT_CAPTURE == 1)
+	setup_event();
+	setup_adxl345_int1_pin();
+	while(1) __WFI();  // Sleep until an event
+#elif(OPT_ADXL345_INT1_DEFER == 1)
+	setup_adxl345_int1_pin();
+	while(1){
+		tru_defer_run();    // The readout posted by the INT1 interrupt
+		tru_defer_wait();   // Sleep until the next post
+	}
+#else
+	setup_adxl345_int1_pin();
+	while(1) __WFI();  // Sleep, the readout runs from the INT1 interrupt
+#endif
+#elif(OPT_ADXL345_MULTI == 1)
+	multi_read();
 #else
 	poll_read();
 #endif
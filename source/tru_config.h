@@ -36,6 +36,8 @@
 #define TRU_CFG_TARGET          TRU_C5SOC
 #define TRU_CFG_CMSIS           1U
 #define TRU_CFG_CMSIS_WEAK_IRQH 0U
+#define TRU_CFG_IRQ_NESTED      0U
+#define TRU_CFG_IRQ_STATS       0U
 #define TRU_CFG_STARTUP         0U
 #define TRU_CFG_EXIT_TO_UBOOT   0U
 #define TRU_CFG_NEON            1U
@@ -43,6 +45,9 @@
 #define TRU_CFG_LOG             1U
 #define TRU_CFG_LOG_RN          1U
 #define TRU_CFG_LOG_LOC         0U
+#define TRU_CFG_UART_TX_RING    1U
+#define TRU_CFG_UART_TX_SIZE    4096U
+#define TRU_CFG_UART_TX_FULL    1U
 
 // ==============================================
 // Apply config to options if not already defined
@@ -64,6 +69,16 @@
 	#define TRU_CMSIS_WEAK_IRQH TRU_CFG_CMSIS_WEAK_IRQH
 #endif
 
+#ifndef TRU_IRQ_NESTED
+	// 1U == IRQ_Handler runs the handlers with IRQs enabled, so higher priority interrupts preempt lower ones
+	#define TRU_IRQ_NESTED TRU_CFG_IRQ_NESTED
+#endif
+
+#ifndef TRU_IRQ_STATS
+	// 1U == IRQ_Handler and FIQ_Handler record the count, handler time and dispatch time of each interrupt, see irq_stats_t in irq_c5soc.h
+	#define TRU_IRQ_STATS TRU_CFG_IRQ_STATS
+#endif
+
 #ifndef TRU_STARTUP
 	#define TRU_STARTUP TRU_CFG_STARTUP
 #endif
@@ -93,6 +108,21 @@
 	#define TRU_LOG_LOC TRU_CFG_LOG_LOC
 #endif
 
+#ifndef TRU_UART_TX_RING
+	// 1U == Print through an interrupt driven transmit ring buffer once tru_hps_uart_tx_init() is called
+	#define TRU_UART_TX_RING TRU_CFG_UART_TX_RING
+#endif
+
+#ifndef TRU_UART_TX_SIZE
+	// Transmit ring buffer size in bytes, must be a power of two
+	#define TRU_UART_TX_SIZE TRU_CFG_UART_TX_SIZE
+#endif
+
+#ifndef TRU_UART_TX_FULL
+	// What to do when the transmit ring buffer is full: 0U = drop new bytes, 1U = block until there is space, 2U = overwrite the oldest bytes
+	#define TRU_UART_TX_FULL TRU_CFG_UART_TX_FULL
+#endif
+
 // ======================
 // Startup configurations
 // ======================
@@ -0,0 +1,73 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250110
+
+	Non-blocking interrupt driven I2C transactions for the ADXL345 using the HPS
+	I2C0 controller.
+*/
+
+#ifndef TRU_ADXL345_ASYNC_H
+#define TRU_ADXL345_ASYNC_H
+
+#include <stdint.h>
+
+#define TRU_ADXL345_I2C_XFER_READ  0U
+#define TRU_ADXL345_I2C_XFER_WRITE 1U
+
+#define TRU_ADXL345_I2C_XFER_STATUS_PENDING 0U
+#define TRU_ADXL345_I2C_XFER_STATUS_DONE    1U
+#define TRU_ADXL345_I2C_XFER_STATUS_ABORTED 2U
+
+typedef struct tru_adxl345_i2c_xfer_s tru_adxl345_i2c_xfer_t;
+typedef void (*tru_adxl345_i2c_xfer_cb_t)(tru_adxl345_i2c_xfer_t *xfer);
+
+// Transaction descriptor.  It is owned by the engine from submit until the
+// callback is called, so it must stay valid (i.e. not on a stack that goes
+// out of scope) during that time
+struct tru_adxl345_i2c_xfer_s{
+	// Set by the caller
+	uint8_t dir;                         // TRU_ADXL345_I2C_XFER_READ or TRU_ADXL345_I2C_XFER_WRITE
+	uint8_t reg_addr;                    // ADXL345 start register address
+	uint32_t len;                        // Number of data bytes to read or write
+	uint8_t *buf;                        // Data buffer
+	tru_adxl345_i2c_xfer_cb_t callback;  // Called on completion from the I2C0 interrupt handler, can be 0
+	void *context;                       // User value for the callback
+
+	// Set by the engine
+	volatile uint8_t status;             // TRU_ADXL345_I2C_XFER_STATUS_*
+	uint32_t abrt_source;                // IC_TX_ABRT_SOURCE value when aborted
+
+	// Private
+	uint32_t tx_count;                   // Commands pushed, including the register address
+	uint32_t rx_count;                   // Bytes received
+	uint32_t cmd_end;                    // Value of the engine command counter after the last command was pushed
+	tru_adxl345_i2c_xfer_t *next;
+};
+
+void tru_adxl345_i2c_async_init(void);
+int tru_adxl345_i2c_async_submit(tru_adxl345_i2c_xfer_t *xfer);
+uint8_t tru_adxl345_i2c_async_busy(void);
+void tru_adxl345_i2c_async_irq_handler(void);
+
+#endif
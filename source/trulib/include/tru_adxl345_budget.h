@@ -0,0 +1,76 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250201
+
+	End-to-end time budget of the ADXL345 readout: bus time, CPU time and
+	output bytes per sample against the sample period, and how many sensors
+	at the same rate each resource could carry.
+*/
+
+#ifndef TRU_ADXL345_BUDGET_H
+#define TRU_ADXL345_BUDGET_H
+
+#include "tru_adxl345_ll.h"
+#include <stdint.h>
+
+// I2C bits on the bus per transaction, besides 9 bits (8 data and ACK) per
+// data byte
+#define TRU_ADXL345_BUDGET_READ_BITS  30U  // Start, address W, register, restart, address R, stop
+#define TRU_ADXL345_BUDGET_WRITE_BITS 20U  // Start, address W, register, stop
+
+typedef struct{
+	uint32_t samples;         // Samples measured
+	uint32_t odr_mhz;         // Measured sample rate
+	uint32_t period_ns;       // Nominal sample period
+	uint32_t bus_ns;          // I2C bus time per sample, from the bits transferred at the SCL rate
+	uint32_t wait_ns;         // CPU time per sample spent waiting on blocking bus transfers
+	uint32_t cpu_ns;          // CPU time per sample spent on the output
+	uint32_t out_bytes_x100;  // Output bytes per sample, times 100
+	uint32_t bus_pct;         // Load of each resource at the nominal rate
+	uint32_t cpu_pct;
+	uint32_t uart_pct;
+	uint32_t headroom_pct;    // 100 less the highest load
+	uint32_t sensors_bus;     // Sensors at this rate that each resource could carry
+	uint32_t sensors_cpu;
+	uint32_t sensors_uart;
+}tru_adxl345_budget_report_t;
+
+typedef struct{
+	uint32_t tick_hz;
+	uint32_t odr_mhz;
+	uint32_t scl_hz;
+	uint32_t uart_bytes_hz;
+	uint64_t start_ticks;
+	tru_adxl345_i2c_stats_t i2c_start;  // Bus counters at the start
+	uint32_t samples;
+	uint64_t wait_ticks;
+	uint64_t cpu_ticks;
+	uint64_t out_bytes;
+}tru_adxl345_budget_t;
+
+void tru_adxl345_budget_init(tru_adxl345_budget_t *b, uint32_t tick_hz, uint32_t odr_mhz, uint32_t scl_hz, uint32_t uart_baud, uint64_t ticks, const tru_adxl345_i2c_stats_t *i2c_stats);
+void tru_adxl345_budget_drain(tru_adxl345_budget_t *b, uint32_t n, uint32_t wait_ticks, uint32_t cpu_ticks, uint32_t out_bytes);
+void tru_adxl345_budget_get_report(const tru_adxl345_budget_t *b, uint64_t ticks, const tru_adxl345_i2c_stats_t *i2c_stats, tru_adxl345_budget_report_t *report);
+
+#endif
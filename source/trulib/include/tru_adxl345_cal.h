@@ -0,0 +1,75 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250209
+
+	ADXL345 offset calibration: averages samples taken at rest, computes the
+	OFSX, OFSY and OFSZ register values and the residual error, and packs
+	the result into a record for persistent storage.
+*/
+
+#ifndef TRU_ADXL345_CAL_H
+#define TRU_ADXL345_CAL_H
+
+#include "tru_adxl345_ll.h"
+#include <stdint.h>
+
+// Axis facing up (+1 g) or down (-1 g) while calibrating, the other two see 0 g
+#define TRU_ADXL345_CAL_X_UP   0
+#define TRU_ADXL345_CAL_X_DOWN 1
+#define TRU_ADXL345_CAL_Y_UP   2
+#define TRU_ADXL345_CAL_Y_DOWN 3
+#define TRU_ADXL345_CAL_Z_UP   4
+#define TRU_ADXL345_CAL_Z_DOWN 5
+
+#define TRU_ADXL345_CAL_OFS_UG      15625U  // Offset register scale, 15.6 mg in any range
+#define TRU_ADXL345_CAL_TOL_UG      15625   // Largest residual accepted, one offset step
+#define TRU_ADXL345_CAL_MAGIC       0x35343343UL  // "C345"
+#define TRU_ADXL345_CAL_VERSION     1U
+#define TRU_ADXL345_CAL_RECORD_SIZE 32U
+
+typedef struct{
+	uint32_t lsb_per_g;          // Output scale for the data format in use
+	uint8_t up;                  // TRU_ADXL345_CAL_*
+	int32_t sum[3];
+	uint32_t n;
+}tru_adxl345_cal_t;
+
+typedef struct{
+	uint32_t count;              // Calibrations saved on this unit
+	uint16_t samples;            // Samples averaged
+	uint8_t up;                  // TRU_ADXL345_CAL_*
+	uint8_t range;               // TRU_ADXL345_RANGE_* when calibrated
+	int8_t ofs[3];               // OFSX, OFSY, OFSZ
+	int32_t residual_ug[3];      // Mean error left with the offsets above
+}tru_adxl345_cal_record_t;
+
+void tru_adxl345_cal_init(tru_adxl345_cal_t *cal, tru_adxl345_data_format_t data_format, uint8_t up);
+void tru_adxl345_cal_reset(tru_adxl345_cal_t *cal);
+void tru_adxl345_cal_add(tru_adxl345_cal_t *cal, const int16_t *xyz);
+int32_t tru_adxl345_cal_error_ug(const tru_adxl345_cal_t *cal, uint32_t axis);
+int8_t tru_adxl345_cal_offset(const tru_adxl345_cal_t *cal, uint32_t axis, int8_t ofs);
+uint32_t tru_adxl345_cal_pack(const tru_adxl345_cal_record_t *rec, uint8_t *buf);
+uint8_t tru_adxl345_cal_unpack(tru_adxl345_cal_record_t *rec, const uint8_t *buf);
+
+#endif
@@ -0,0 +1,54 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250130
+
+	ADXL345 configuration as one register image, applied with burst writes of
+	only the registers that changed, and a driver shadow of the writable
+	registers.
+*/
+
+#ifndef TRU_ADXL345_CFG_H
+#define TRU_ADXL345_CFG_H
+
+#include "tru_adxl345_ll.h"
+#include <stdint.h>
+
+// Register image from THRESH_TAP to FIFO_CTL
+#define TRU_ADXL345_CFG_FIRST_ADDR TRU_ADXL345_THRESH_TAP_ADDR
+#define TRU_ADXL345_CFG_SIZE       (TRU_ADXL345_FIFO_CTL_ADDR - TRU_ADXL345_THRESH_TAP_ADDR + 1)
+#define TRU_ADXL345_CFG_BRIDGE     2U  // Unchanged registers rewritten to join two runs, cheaper than a new transaction
+
+void tru_adxl345_config_reset(tru_adxl345_config_t *cfg);
+void tru_adxl345_config_read(tru_adxl345_dev_t *dev, tru_adxl345_config_t *cfg);
+uint32_t tru_adxl345_config_apply(tru_adxl345_dev_t *dev, tru_adxl345_config_t *cur, const tru_adxl345_config_t *next);
+void tru_adxl345_shadow_load(tru_adxl345_dev_t *dev);
+tru_adxl345_config_t *tru_adxl345_shadow(tru_adxl345_dev_t *dev);
+uint8_t tru_adxl345_reg_read(tru_adxl345_dev_t *dev, uint32_t addr);
+void tru_adxl345_reg_write(tru_adxl345_dev_t *dev, uint32_t addr, uint8_t val);
+void tru_adxl345_reg_update(tru_adxl345_dev_t *dev, uint32_t addr, uint8_t mask, uint8_t val);
+uint32_t tru_adxl345_shadow_flush(tru_adxl345_dev_t *dev);
+void tru_adxl345_shadow_written(tru_adxl345_dev_t *dev, uint32_t addr, uint32_t len);
+void tru_adxl345_shadow_get_stats(tru_adxl345_dev_t *dev, tru_adxl345_shadow_stats_t *stats);
+
+#endif
@@ -0,0 +1,52 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250112
+
+	DMA (PL330 DMA-330) readout of the ADXL345 FIFO using the HPS I2C0
+	controller.
+*/
+
+#ifndef TRU_ADXL345_DMA_H
+#define TRU_ADXL345_DMA_H
+
+#include <stdint.h>
+#include "alt_dma.h"
+
+// Bytes per FIFO entry (DATAX0 to DATAZ1)
+#define TRU_ADXL345_DMA_ENTRY_SIZE 6U
+
+// The receive buffer is invalidated from the cache after each drain, so it
+// must start on a cache line and be a whole number of cache lines
+#define TRU_ADXL345_DMA_BUF_ALIGN  32U
+#define TRU_ADXL345_DMA_BUF_SIZE(n) ((((n) * TRU_ADXL345_DMA_ENTRY_SIZE) + TRU_ADXL345_DMA_BUF_ALIGN - 1U) & ~(TRU_ADXL345_DMA_BUF_ALIGN - 1U))
+
+typedef void (*tru_adxl345_dma_cb_t)(void *buf, uint32_t n);
+
+ALT_STATUS_CODE tru_adxl345_dma_init(ALT_DMA_CHANNEL_t tx_channel, ALT_DMA_CHANNEL_t rx_channel, ALT_DMA_EVENT_t evt);
+ALT_STATUS_CODE tru_adxl345_dma_fifo_drain(void *buf, uint32_t n, tru_adxl345_dma_cb_t callback);
+uint8_t tru_adxl345_dma_busy(void);
+void tru_adxl345_dma_cancel(void);
+void tru_adxl345_dma_irq_handler(void);
+
+#endif
@@ -0,0 +1,71 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250203
+
+	Event capture with the ADXL345 FIFO trigger mode: the FIFO keeps a
+	history of samples, a tap or activity interrupt freezes it, and the
+	samples from before and after the trigger are collected into a
+	timestamped event record.
+*/
+
+#ifndef TRU_ADXL345_EVENT_H
+#define TRU_ADXL345_EVENT_H
+
+#include "tru_adxl345_ll.h"
+#include <stdint.h>
+
+#define TRU_ADXL345_EVENT_MAX 64U  // Samples per event record
+
+#define TRU_ADXL345_EVENT_STATE_ARMED     0U  // Waiting for the trigger, the CPU has nothing to do
+#define TRU_ADXL345_EVENT_STATE_CAPTURING 1U  // Triggered, collecting the samples after the trigger
+
+typedef struct{
+	uint32_t seq;                          // Event number
+	uint64_t trigger_ticks;                // Timer count when the trigger interrupt was taken
+	uint64_t first_ticks;                  // Time of the first sample
+	uint32_t period_ticks;                 // Sample period
+	uint32_t pre;                          // Samples before the trigger, the trigger is between sample pre - 1 and pre
+	uint32_t n;                            // Samples held
+	tru_adxl345_int_source_t int_source;   // What triggered
+	uint8_t sample[TRU_ADXL345_EVENT_MAX * 6] __attribute__((aligned(4)));  // Entries as read from DATAX0 to DATAZ1, oldest first
+}tru_adxl345_event_t;
+
+typedef struct{
+	tru_adxl345_dev_t *dev;
+	uint8_t state;
+	uint8_t pre;                           // FIFO_CTL samples, history kept at the trigger
+	uint32_t total;                        // Samples per event
+	uint8_t trigger_mask;                  // INT_SOURCE bits that count as a trigger
+	uint32_t period_ticks;
+	uint32_t events;                       // Events completed
+	uint32_t truncated;                    // Events with fewer history samples than asked for
+	tru_adxl345_event_t event;
+}tru_adxl345_event_cap_t;
+
+void tru_adxl345_event_init(tru_adxl345_event_cap_t *cap, tru_adxl345_dev_t *dev, uint32_t tick_hz, uint32_t odr_mhz, uint8_t pre, uint32_t post, uint8_t trigger_mask);
+void tru_adxl345_event_arm(tru_adxl345_event_cap_t *cap);
+tru_adxl345_event_t *tru_adxl345_event_irq(tru_adxl345_event_cap_t *cap, uint64_t ticks, tru_adxl345_int_source_t *int_source);
+uint64_t tru_adxl345_event_sample_ticks(const tru_adxl345_event_t *event, uint32_t i);
+
+#endif
@@ -0,0 +1,69 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250207
+
+	ADXL345 free-fall detection: the THRESH_FF and TIME_FF settings in
+	physical units, event timestamps and the latency from the start of the
+	fall to the notification.
+*/
+
+#ifndef TRU_ADXL345_FF_H
+#define TRU_ADXL345_FF_H
+
+#include "tru_adxl345_ll.h"
+#include <stdint.h>
+
+#define TRU_ADXL345_FF_THRESH_UG_LSB 62500U  // THRESH_FF scale, micro g
+#define TRU_ADXL345_FF_TIME_MS_LSB   5U      // TIME_FF scale
+
+typedef struct{
+	uint32_t events;
+	uint32_t fall_us;            // TIME_FF, the fall before the device raises the interrupt
+	uint32_t detect_max_us;      // Up to one sample period more to see it
+	uint32_t notify_min_us;      // INT1 handler entry to notification
+	uint32_t notify_max_us;
+	uint32_t notify_mean_us;
+	uint32_t onset_max_us;       // Start of the fall to notification, worst case of the above
+}tru_adxl345_ff_stats_t;
+
+typedef struct{
+	uint32_t tick_hz;
+	uint32_t fall_ticks;         // TIME_FF in timer ticks
+	uint32_t period_ticks;       // Sample period in timer ticks
+	uint32_t events;
+	uint64_t irq_ticks;          // INT1 handler entry of the last event
+	uint64_t onset_ticks;        // Estimated start of the last fall
+	uint32_t notify_min;         // In ticks
+	uint32_t notify_max;
+	uint64_t notify_sum;
+}tru_adxl345_ff_t;
+
+uint8_t tru_adxl345_ff_thresh(uint32_t mg);
+uint8_t tru_adxl345_ff_time(uint32_t ms);
+void tru_adxl345_ff_config(tru_adxl345_config_t *cfg, uint32_t mg, uint32_t ms);
+void tru_adxl345_ff_init(tru_adxl345_ff_t *ff, uint32_t tick_hz, uint32_t odr_mhz, uint8_t time_ff);
+uint64_t tru_adxl345_ff_event(tru_adxl345_ff_t *ff, uint64_t irq_ticks, uint64_t notify_ticks);
+void tru_adxl345_ff_get_stats(const tru_adxl345_ff_t *ff, tru_adxl345_ff_stats_t *stats);
+
+#endif
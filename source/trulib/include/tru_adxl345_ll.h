@@ -21,7 +21,7 @@
 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 	SOFTWARE.
 
-	Version: 20241222
+	Version: 20250130
 */
 
 #ifndef TRU_ADXL345_LL_H
@@ -35,7 +35,18 @@
 #define TRU_ADXL345_I2C_SCL_LOW_TIME_NS  1300
 #define TRU_ADXL345_I2C_RISE_TIME_NS     300
 #define TRU_ADXL345_I2C_FALL_TIME_NS     300
-#define TRU_ADXL345_I2C_DEV_ADDR         0x53
+#define TRU_ADXL345_I2C_DEV_ADDR         0x53  // SDO/ALT ADDRESS pin low, as on the DE10-Nano
+#define TRU_ADXL345_I2C_ALT_DEV_ADDR     0x1d  // SDO/ALT ADDRESS pin high
+#define TRU_ADXL345_I2C_BUSES            4     // HPS I2C0 to I2C3
+
+// Standard mode (100kHz) timing values from the I2C-bus specification (UM10204)
+#define TRU_ADXL345_I2C_SS_SCL_HIGH_TIME_NS 4000
+#define TRU_ADXL345_I2C_SS_SCL_LOW_TIME_NS  4700
+#define TRU_ADXL345_I2C_SS_RISE_TIME_NS     1000
+#define TRU_ADXL345_I2C_SS_FALL_TIME_NS     300
+
+// Maximum width of spikes that must be suppressed by the input filter (I2C-bus specification tSP)
+#define TRU_ADXL345_I2C_SPIKE_TIME_NS       50
 
 #define TRU_ADXL345_FIFO_DEPTH   32
 
@@ -71,6 +82,8 @@
 #define TRU_ADXL345_FIFOMODE_STREAM  2
 #define TRU_ADXL345_FIFOMODE_TRIGGER 3
 
+#define TRU_ADXL345_DEVID 0xe5U  // Fixed value read from the DEVID register
+
 #define TRU_ADXL345_DEVID_ADDR          0x00
 #define TRU_ADXL345_THRESH_TAP_ADDR     0x1d
 #define TRU_ADXL345_OFSX_ADDR           0x1e
@@ -257,10 +270,80 @@ typedef union{
 
 #define TRU_ADXL345_FIFO_STATUS_PTR(ptr) ((tru_adxl345_fifo_status_t *)ptr)
 
-void tru_adxl345_i2c_init(uint32_t l4_sp_clk_freq_hz, uint32_t i2c_dev_speed_khz, uint8_t mode10bit, uint16_t dev_addr);
-void tru_adxl345_i2c_read_bm(void *buf, uint32_t len, uint32_t reg_addr_start);
-void tru_adxl345_i2c_read(void *buf, uint32_t len, uint32_t reg_addr_start);
-void tru_adxl345_i2c_write(void *buf, uint32_t len, uint32_t reg_addr_start);
-void tru_adxl345_i2c_stop_flush_fifo(void);
+// Register image from THRESH_TAP to FIFO_CTL, one member per register in
+// address order, all bytes so there is no padding.  The read only members are
+// placeholders and are never written
+typedef struct{
+	uint8_t thresh_tap;                            // 0x1d THRESHOLD = THR * 62.5 mg
+	int8_t ofsx;                                   // 0x1e OFFSET = OFS * 15.6mg
+	int8_t ofsy;                                   // 0x1f
+	int8_t ofsz;                                   // 0x20
+	uint8_t dur;                                   // 0x21 DURATION = DUR * 625 us
+	uint8_t latent;                                // 0x22 LATENT = LAT * 1.25ms
+	uint8_t window;                                // 0x23 WINDOW = WIN * 1.25ms
+	uint8_t thresh_act;                            // 0x24 62.5 mg/LSB
+	uint8_t thresh_inact;                          // 0x25 62.5 mg/LSB
+	uint8_t time_inact;                            // 0x26 1 s/LSB
+	tru_adxl345_act_inact_ctl_t act_inact_ctl;     // 0x27
+	uint8_t thresh_ff;                             // 0x28 62.5 mg/LSB
+	uint8_t time_ff;                               // 0x29 5 ms/LSB
+	tru_adxl345_tap_axes_t tap_axes;               // 0x2a
+	tru_adxl345_act_tap_status_t act_tap_status;   // 0x2b read only
+	tru_adxl345_bw_rate_t bw_rate;                 // 0x2c
+	tru_adxl345_power_ctl_t power_ctl;             // 0x2d
+	tru_adxl345_int_enable_t int_enable;           // 0x2e
+	tru_adxl345_int_map_t int_map;                 // 0x2f
+	tru_adxl345_int_source_t int_source;           // 0x30 read only
+	tru_adxl345_data_format_t data_format;         // 0x31
+	uint8_t data[6];                               // 0x32 to 0x37 read only
+	tru_adxl345_fifo_ctl_t fifo_ctl;               // 0x38
+}tru_adxl345_config_t;
+
+typedef struct{
+	uint32_t hits;     // Register reads served from the shadow
+	uint32_t flushes;  // Flushes that wrote to the device
+}tru_adxl345_shadow_stats_t;
+
+// Device handle, one per sensor.  Several sensors can share a controller,
+// e.g. two ADXL345s on one bus with different SDO/ALT ADDRESS strapping
+typedef struct{
+	uint32_t i2c_base;                        // HPS I2C controller base, e.g. TRU_HPS_I2C0_BASE
+	uint16_t addr;                            // 7-bit target address
+	tru_adxl345_config_t shadow;              // What the device should hold, see tru_adxl345_cfg.c
+	tru_adxl345_config_t device;              // What the device holds
+	tru_adxl345_shadow_stats_t shadow_stats;
+}tru_adxl345_dev_t;
+
+// I2C controller SCL timing, in number of l4_sp_clk cycles
+typedef struct{
+	uint8_t speed;    // TRU_HPS_I2C_CON_SPEED_100K or TRU_HPS_I2C_CON_SPEED_400K
+	uint32_t spklen;  // IC_FS_SPKLEN
+	uint32_t hcnt;    // IC_SS_SCL_HCNT or IC_FS_SCL_HCNT
+	uint32_t lcnt;    // IC_SS_SCL_LCNT or IC_FS_SCL_LCNT
+}tru_adxl345_i2c_scl_t;
+
+// Bus transaction counters per controller, for all of the blocking,
+// non-blocking and DMA transfers
+typedef struct{
+	uint32_t reads;         // Read transactions
+	uint32_t writes;        // Write transactions
+	uint32_t read_bytes;    // Data bytes read
+	uint32_t write_bytes;   // Data bytes written
+	uint32_t tar_switches;  // Target address changes between devices
+}tru_adxl345_i2c_stats_t;
+
+void tru_adxl345_dev_init(tru_adxl345_dev_t *dev, uint32_t i2c_base, uint16_t addr);
+void tru_adxl345_i2c_scl_calc(uint32_t l4_sp_clk_freq_hz, uint32_t i2c_dev_speed_hz, tru_adxl345_i2c_scl_t *scl);
+uint32_t tru_adxl345_i2c_scl_freq(uint32_t l4_sp_clk_freq_hz, const tru_adxl345_i2c_scl_t *scl);
+uint32_t tru_adxl345_i2c_scl_readback(tru_adxl345_dev_t *dev, uint32_t l4_sp_clk_freq_hz, tru_adxl345_i2c_scl_t *scl);
+void tru_adxl345_i2c_init(tru_adxl345_dev_t *dev, uint32_t l4_sp_clk_freq_hz, uint32_t i2c_dev_speed_khz);
+void tru_adxl345_i2c_select(tru_adxl345_dev_t *dev);
+void tru_adxl345_i2c_read_bm(tru_adxl345_dev_t *dev, void *buf, uint32_t len, uint32_t reg_addr_start);
+void tru_adxl345_i2c_read(tru_adxl345_dev_t *dev, void *buf, uint32_t len, uint32_t reg_addr_start);
+void tru_adxl345_i2c_write(tru_adxl345_dev_t *dev, void *buf, uint32_t len, uint32_t reg_addr_start);
+void tru_adxl345_i2c_stop_flush_fifo(tru_adxl345_dev_t *dev);
+void tru_adxl345_fifo_drain(tru_adxl345_dev_t *dev, void *buf, uint32_t n);
+void tru_adxl345_i2c_count(uint32_t i2c_base, uint8_t write, uint32_t transactions, uint32_t bytes);
+void tru_adxl345_i2c_get_stats(uint32_t i2c_base, tru_adxl345_i2c_stats_t *stats);
 
 #endif
@@ -0,0 +1,74 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250205
+
+	Wake-on-motion power management for the ADXL345, using the linked
+	activity and inactivity functions with AUTO_SLEEP, and the wake-up
+	latency from the activity interrupt to the first full rate sample.
+*/
+
+#ifndef TRU_ADXL345_PM_H
+#define TRU_ADXL345_PM_H
+
+#include "tru_adxl345_ll.h"
+#include <stdint.h>
+
+#define TRU_ADXL345_PM_SLEPT 1U  // The device went to sleep
+#define TRU_ADXL345_PM_WOKE  2U  // The device woke up
+
+typedef struct{
+	uint32_t sleeps;
+	uint32_t wakes;
+	uint32_t asleep_pct;         // Time asleep since init
+	uint32_t latency_min_us;     // Activity interrupt to the first full rate sample
+	uint32_t latency_max_us;
+	uint32_t latency_mean_us;
+	uint32_t detect_max_us;      // Motion to activity interrupt, up to one sample at the wakeup rate
+}tru_adxl345_pm_stats_t;
+
+typedef struct{
+	tru_adxl345_dev_t *dev;
+	uint32_t tick_hz;
+	uint8_t wakeup;              // TRU_ADXL345_WAKEUP_*
+	uint8_t asleep;
+	uint8_t int_enable;          // INT_ENABLE to restore on wake-up
+	uint64_t init_ticks;
+	uint64_t sleep_ticks;        // Start of the current sleep
+	uint64_t asleep_ticks;       // Total time asleep before the current sleep
+	uint64_t wake_ticks;         // Activity interrupt waiting for its first full rate sample, 0 = none
+	uint32_t sleeps;
+	uint32_t wakes;
+	uint32_t latency_min;        // In ticks
+	uint32_t latency_max;
+	uint64_t latency_sum;
+	uint32_t latency_count;
+}tru_adxl345_pm_t;
+
+void tru_adxl345_pm_config(tru_adxl345_config_t *cfg, uint8_t thresh_act, uint8_t thresh_inact, uint8_t time_inact, uint8_t wakeup);
+void tru_adxl345_pm_init(tru_adxl345_pm_t *pm, tru_adxl345_dev_t *dev, uint32_t tick_hz, uint8_t wakeup, uint64_t ticks);
+uint8_t tru_adxl345_pm_irq(tru_adxl345_pm_t *pm, uint64_t ticks, tru_adxl345_int_source_t int_source);
+uint8_t tru_adxl345_pm_sample(tru_adxl345_pm_t *pm, uint64_t sample_ticks, uint32_t *latency_us);
+void tru_adxl345_pm_get_stats(const tru_adxl345_pm_t *pm, uint64_t ticks, tru_adxl345_pm_stats_t *stats);
+
+#endif
@@ -0,0 +1,77 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250130
+
+	Round-robin polling of several ADXL345 sensors, on one or more HPS I2C
+	controllers, with per bus sample throughput.
+*/
+
+#ifndef TRU_ADXL345_SCHED_H
+#define TRU_ADXL345_SCHED_H
+
+#include "tru_adxl345_ll.h"
+#include "tru_adxl345_ts.h"
+#include <stdint.h>
+
+#define TRU_ADXL345_SCHED_MAX 4U  // Sensors per scheduler
+
+typedef struct tru_adxl345_sched tru_adxl345_sched_t;
+
+// Called after a sensor's FIFO has been drained and its drain timestamped,
+// with the n entries (6 bytes each) oldest first
+typedef void (*tru_adxl345_sched_cb_t)(tru_adxl345_sched_t *sched, uint32_t index, const void *buf, uint32_t n, tru_adxl345_int_source_t int_source);
+
+typedef struct{
+	tru_adxl345_dev_t *dev;
+	tru_adxl345_ts_t ts;    // Drain timestamps, also decides when the sensor is due
+	uint8_t watermark;      // FIFO entries worth a drain
+	uint32_t samples;       // Sample number of the first entry, or of the first lost sample, of the drain being reported
+	uint32_t polls;         // FIFO_STATUS reads
+	uint32_t drains;
+}tru_adxl345_sched_sensor_t;
+
+typedef struct{
+	uint32_t sensors;       // Sensors on the bus
+	uint32_t samples;       // Samples read
+	uint32_t samples_hz;    // Samples read per second since the first poll
+	uint32_t polls;         // FIFO_STATUS reads
+	uint32_t tar_switches;  // Target address changes
+}tru_adxl345_sched_bus_stats_t;
+
+struct tru_adxl345_sched{
+	tru_adxl345_sched_sensor_t sensor[TRU_ADXL345_SCHED_MAX];
+	uint32_t count;
+	uint32_t next;          // Sensor looked at first in the next round
+	uint32_t tick_hz;
+	uint64_t start_ticks;   // First poll, 0 = not started
+	tru_adxl345_sched_cb_t callback;
+	uint8_t buf[TRU_ADXL345_FIFO_DEPTH * 6] __attribute__((aligned(4)));  // Drained entries
+};
+
+void tru_adxl345_sched_init(tru_adxl345_sched_t *sched, uint32_t tick_hz, tru_adxl345_sched_cb_t callback);
+int tru_adxl345_sched_add(tru_adxl345_sched_t *sched, tru_adxl345_dev_t *dev, uint32_t odr_mhz, uint8_t watermark);
+uint32_t tru_adxl345_sched_poll(tru_adxl345_sched_t *sched);
+void tru_adxl345_sched_get_bus_stats(const tru_adxl345_sched_t *sched, uint32_t i2c_base, tru_adxl345_sched_bus_stats_t *stats);
+
+#endif
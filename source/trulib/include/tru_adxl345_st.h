@@ -0,0 +1,75 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250211
+
+	ADXL345 self-test: the output change with the DATA_FORMAT self-test bit
+	set, checked against the datasheet limits for the supply voltage and
+	data format, for a go/no-go check at startup.
+*/
+
+#ifndef TRU_ADXL345_ST_H
+#define TRU_ADXL345_ST_H
+
+#include "tru_adxl345_ll.h"
+#include <stdint.h>
+
+#define TRU_ADXL345_ST_SETTLE     4U        // Samples dropped after each change, the datasheet asks for 4 at 100Hz
+#define TRU_ADXL345_ST_TIMEOUT_MS 1000U     // Fails a device that stops giving samples
+
+// Failure reasons
+#define TRU_ADXL345_ST_FAIL_DEVID   0x01U
+#define TRU_ADXL345_ST_FAIL_TIMEOUT 0x02U
+#define TRU_ADXL345_ST_FAIL_X       0x10U  // Axis output change outside the limits
+#define TRU_ADXL345_ST_FAIL_Y       0x20U
+#define TRU_ADXL345_ST_FAIL_Z       0x40U
+
+typedef struct{
+	uint8_t pass;                // 1 = go, 0 = no-go
+	uint8_t fail;                // TRU_ADXL345_ST_FAIL_* bits
+	uint8_t devid;
+	uint32_t samples;            // Averaged with self-test off, and again on
+	int32_t off[3];              // Mean output, x, y, z in LSB of the test data format
+	int32_t on[3];
+	int32_t delta[3];            // Output change, on less off
+	int32_t min[3];              // Limits for the supply and test data format
+	int32_t max[3];
+	uint32_t time_us;            // Duration of the whole test
+}tru_adxl345_st_result_t;
+
+typedef struct{
+	uint32_t runs;
+	uint32_t passes;
+	uint32_t axis_fails[3];
+	uint32_t timeouts;
+	int32_t delta_min[3];
+	int32_t delta_max[3];
+	uint32_t time_max_us;
+}tru_adxl345_st_stats_t;
+
+void tru_adxl345_st_limits(uint32_t vs_mv, tru_adxl345_data_format_t data_format, int32_t *min, int32_t *max);
+void tru_adxl345_st_run(tru_adxl345_dev_t *dev, uint32_t samples, uint32_t vs_mv, uint32_t tick_hz, tru_adxl345_st_result_t *result);
+void tru_adxl345_st_stats_init(tru_adxl345_st_stats_t *stats);
+void tru_adxl345_st_stats_add(tru_adxl345_st_stats_t *stats, const tru_adxl345_st_result_t *result);
+
+#endif
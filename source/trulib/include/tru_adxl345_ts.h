@@ -0,0 +1,86 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250205
+
+	Sample timestamping for the ADXL345 FIFO with an online estimate of the
+	real output data rate, and sample loss accounting.
+*/
+
+#ifndef TRU_ADXL345_TS_H
+#define TRU_ADXL345_TS_H
+
+#include <stdint.h>
+
+#define TRU_ADXL345_TS_Q            12U    // Fractional bits of the fixed point tick values
+#define TRU_ADXL345_TS_PHASE_SHIFT  3U     // Phase gain = 1/8 of the residual per drain
+#define TRU_ADXL345_TS_FREQ_SHIFT   7U     // Period gain = 1/128 of the residual per sample
+#define TRU_ADXL345_TS_LOCK_DRAINS  16U    // Drains using the long baseline period estimate before tracking
+
+typedef struct{
+	uint32_t odr_mhz;        // Estimated output data rate in mHz
+	int32_t drift_ppm;       // Estimated rate against the nominal rate
+	int32_t jitter_min_us;   // Smallest and largest residual of a drain time against the prediction
+	int32_t jitter_max_us;
+	uint32_t jitter_mean_us; // Mean absolute residual
+	uint32_t resyncs;        // Drains too far off the prediction to track without a reported overrun
+	uint32_t read;           // Samples read
+	uint32_t lost;           // Samples lost, inferred from the drain times of overrun drains
+	uint32_t gaps;           // Drains preceded by lost samples
+	uint32_t overruns;       // Drains with the INT_SOURCE overrun bit set
+	uint32_t late;           // Drains with more entries than the watermark, i.e. read more than one period late
+}tru_adxl345_ts_stats_t;
+
+typedef struct{
+	uint32_t tick_hz;
+	uint64_t nominal_period_q;  // Sample period in timer ticks << TRU_ADXL345_TS_Q
+	uint64_t period_q;          // Estimated sample period
+	uint64_t newest_q;          // Corrected time of the newest sample read
+	uint64_t first_ticks;       // Long baseline start
+	uint32_t drains;
+	uint32_t samples;           // Samples since the long baseline start
+	int32_t resid_min;          // Residual statistics in ticks
+	int32_t resid_max;
+	uint64_t resid_abs_sum;
+	uint32_t resid_count;
+	uint32_t resyncs;
+	uint32_t watermark;         // FIFO entries that trigger a drain
+	uint32_t gap;               // Samples lost right before the last drain
+	uint32_t read;              // Loss counters
+	uint32_t lost;
+	uint32_t gaps;
+	uint32_t overruns;
+	uint32_t late;
+}tru_adxl345_ts_t;
+
+uint32_t tru_adxl345_rate_to_mhz(uint8_t rate);
+void tru_adxl345_ts_init(tru_adxl345_ts_t *ts, uint32_t tick_hz, uint32_t odr_mhz);
+void tru_adxl345_ts_set_watermark(tru_adxl345_ts_t *ts, uint32_t watermark);
+void tru_adxl345_ts_resume(tru_adxl345_ts_t *ts);
+uint64_t tru_adxl345_ts_drain(tru_adxl345_ts_t *ts, uint64_t ticks, uint32_t n, uint8_t overrun);
+uint64_t tru_adxl345_ts_sample(const tru_adxl345_ts_t *ts, uint32_t n, uint32_t i);
+uint64_t tru_adxl345_ts_poll_time(const tru_adxl345_ts_t *ts, uint32_t n);
+uint64_t tru_adxl345_ts_to_us(const tru_adxl345_ts_t *ts, uint64_t ticks);
+void tru_adxl345_ts_get_stats(const tru_adxl345_ts_t *ts, tru_adxl345_ts_stats_t *stats);
+
+#endif
@@ -0,0 +1,72 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250124
+
+	Adaptive FIFO watermark for the ADXL345, picks the number of entries per
+	drain from the output data rate, the measured drain time and the output
+	backlog.
+*/
+
+#ifndef TRU_ADXL345_WM_H
+#define TRU_ADXL345_WM_H
+
+#include "tru_adxl345_ll.h"
+#include <stdint.h>
+
+#define TRU_ADXL345_WM_MAX          31U  // Largest FIFO_CTL samples value
+#define TRU_ADXL345_WM_CALM_DRAINS  32U  // Drains without a slow sign before the watermark is lowered
+#define TRU_ADXL345_WM_BACKLOG_PCT  50U  // Output backlog above this is a slow consumer
+#define TRU_ADXL345_WM_BUSY_DECAY   4U   // Worst drain time decays by 1/16 per drain
+
+typedef struct{
+	uint8_t watermark;   // Current watermark
+	uint8_t lo;          // Current limits, from the interrupt rate budget and the latency target and headroom
+	uint8_t hi;
+	uint32_t irq_mhz;    // Measured drain (interrupt) rate in mHz
+	uint32_t busy_us;    // Decaying worst time from watermark to the end of a drain
+	uint32_t changes;    // Watermark changes
+}tru_adxl345_wm_stats_t;
+
+typedef struct{
+	uint32_t tick_hz;
+	uint32_t odr_mhz;
+	uint32_t period_ticks;  // Sample period
+	uint8_t lo_irq;         // Smallest watermark within the interrupt rate budget
+	uint8_t hi_latency;     // Largest watermark within the latency target
+	uint8_t watermark;
+	uint8_t lo;
+	uint8_t hi;
+	uint32_t calm;          // Drains since the last slow sign
+	uint32_t busy_max;      // Decaying worst drain time in ticks
+	uint64_t win_ticks;     // Interrupt rate measurement window start
+	uint32_t win_drains;
+	uint32_t irq_mhz;
+	uint32_t changes;
+}tru_adxl345_wm_t;
+
+void tru_adxl345_wm_init(tru_adxl345_wm_t *wm, uint32_t tick_hz, uint32_t odr_mhz, uint8_t watermark, uint32_t latency_us, uint32_t max_irq_hz);
+uint8_t tru_adxl345_wm_update(tru_adxl345_wm_t *wm, uint64_t ticks, uint32_t n, uint32_t busy_ticks, uint32_t backlog_pct);
+void tru_adxl345_wm_get_stats(const tru_adxl345_wm_t *wm, tru_adxl345_wm_stats_t *stats);
+
+#endif
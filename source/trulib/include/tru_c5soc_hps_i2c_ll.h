@@ -88,7 +88,7 @@
 #define TRU_HPS_I2C_IC_TXFLR_OFFSET              0x74U
 #define TRU_HPS_I2C_IC_RXFLR_OFFSET              0x78U
 #define TRU_HPS_I2C_IC_SDA_HOLD_OFFSET           0x7cU
-#define TRU_HPS_I2C_IC_ABRT_SOURCE_OFFSET        0x80U
+#define TRU_HPS_I2C_IC_TX_ABRT_SOURCE_OFFSET     0x80U
 #define TRU_HPS_I2C_IC_SLV_DATA_NACK_ONLY_OFFSET 0x84U
 #define TRU_HPS_I2C_IC_DMA_CR_OFFSET             0x88U
 #define TRU_HPS_I2C_IC_DMA_TDLR_OFFSET           0x8cU
@@ -132,7 +132,7 @@
 #define TRU_HPS_I2C0_IC_TXFLR_ADDR              (TRU_HPS_I2C0_BASE + TRU_HPS_I2C_IC_TXFLR_OFFSET)
 #define TRU_HPS_I2C0_IC_RXFLR_ADDR              (TRU_HPS_I2C0_BASE + TRU_HPS_I2C_IC_RXFLR_OFFSET)
 #define TRU_HPS_I2C0_IC_SDA_HOLD_ADDR           (TRU_HPS_I2C0_BASE + TRU_HPS_I2C_IC_SDA_HOLD_OFFSET)
-#define TRU_HPS_I2C0_IC_ABRT_SOURCE_ADDR        (TRU_HPS_I2C0_BASE + TRU_HPS_I2C_IC_ABRT_SOURCE_OFFSET)
+#define TRU_HPS_I2C0_IC_TX_ABRT_SOURCE_ADDR     (TRU_HPS_I2C0_BASE + TRU_HPS_I2C_IC_TX_ABRT_SOURCE_OFFSET)
 #define TRU_HPS_I2C0_IC_SLV_DATA_NACK_ONLY_ADDR (TRU_HPS_I2C0_BASE + TRU_HPS_I2C_IC_SLV_DATA_NACK_ONLY_OFFSET)
 #define TRU_HPS_I2C0_IC_DMA_CR_ADDR             (TRU_HPS_I2C0_BASE + TRU_HPS_I2C_IC_DMA_CR_OFFSET)
 #define TRU_HPS_I2C0_IC_SDA_SETUP_ADDR          (TRU_HPS_I2C0_BASE + TRU_HPS_I2C_IC_SDA_SETUP_OFFSET)
@@ -174,7 +174,7 @@
 #define TRU_HPS_I2C1_IC_TXFLR_ADDR              (TRU_HPS_I2C1_BASE + TRU_HPS_I2C_IC_TXFLR_OFFSET)
 #define TRU_HPS_I2C1_IC_RXFLR_ADDR              (TRU_HPS_I2C1_BASE + TRU_HPS_I2C_IC_RXFLR_OFFSET)
 #define TRU_HPS_I2C1_IC_SDA_HOLD_ADDR           (TRU_HPS_I2C1_BASE + TRU_HPS_I2C_IC_SDA_HOLD_OFFSET)
-#define TRU_HPS_I2C1_IC_ABRT_SOURCE_ADDR        (TRU_HPS_I2C1_BASE + TRU_HPS_I2C_IC_ABRT_SOURCE_OFFSET)
+#define TRU_HPS_I2C1_IC_TX_ABRT_SOURCE_ADDR     (TRU_HPS_I2C1_BASE + TRU_HPS_I2C_IC_TX_ABRT_SOURCE_OFFSET)
 #define TRU_HPS_I2C1_IC_SLV_DATA_NACK_ONLY_ADDR (TRU_HPS_I2C1_BASE + TRU_HPS_I2C_IC_SLV_DATA_NACK_ONLY_OFFSET)
 #define TRU_HPS_I2C1_IC_DMA_CR_ADDR             (TRU_HPS_I2C1_BASE + TRU_HPS_I2C_IC_DMA_CR_OFFSET)
 #define TRU_HPS_I2C1_IC_SDA_SETUP_ADDR          (TRU_HPS_I2C1_BASE + TRU_HPS_I2C_IC_SDA_SETUP_OFFSET)
@@ -216,7 +216,7 @@
 #define TRU_HPS_I2C2_IC_TXFLR_ADDR              (TRU_HPS_I2C2_BASE + TRU_HPS_I2C_IC_TXFLR_OFFSET)
 #define TRU_HPS_I2C2_IC_RXFLR_ADDR              (TRU_HPS_I2C2_BASE + TRU_HPS_I2C_IC_RXFLR_OFFSET)
 #define TRU_HPS_I2C2_IC_SDA_HOLD_ADDR           (TRU_HPS_I2C2_BASE + TRU_HPS_I2C_IC_SDA_HOLD_OFFSET)
-#define TRU_HPS_I2C2_IC_ABRT_SOURCE_ADDR        (TRU_HPS_I2C2_BASE + TRU_HPS_I2C_IC_ABRT_SOURCE_OFFSET)
+#define TRU_HPS_I2C2_IC_TX_ABRT_SOURCE_ADDR     (TRU_HPS_I2C2_BASE + TRU_HPS_I2C_IC_TX_ABRT_SOURCE_OFFSET)
 #define TRU_HPS_I2C2_IC_SLV_DATA_NACK_ONLY_ADDR (TRU_HPS_I2C2_BASE + TRU_HPS_I2C_IC_SLV_DATA_NACK_ONLY_OFFSET)
 #define TRU_HPS_I2C2_IC_DMA_CR_ADDR             (TRU_HPS_I2C2_BASE + TRU_HPS_I2C_IC_DMA_CR_OFFSET)
 #define TRU_HPS_I2C2_IC_SDA_SETUP_ADDR          (TRU_HPS_I2C2_BASE + TRU_HPS_I2C_IC_SDA_SETUP_OFFSET)
@@ -258,7 +258,7 @@
 #define TRU_HPS_I2C3_IC_TXFLR_ADDR              (TRU_HPS_I2C3_BASE + TRU_HPS_I2C_IC_TXFLR_OFFSET)
 #define TRU_HPS_I2C3_IC_RXFLR_ADDR              (TRU_HPS_I2C3_BASE + TRU_HPS_I2C_IC_RXFLR_OFFSET)
 #define TRU_HPS_I2C3_IC_SDA_HOLD_ADDR           (TRU_HPS_I2C3_BASE + TRU_HPS_I2C_IC_SDA_HOLD_OFFSET)
-#define TRU_HPS_I2C3_IC_ABRT_SOURCE_ADDR        (TRU_HPS_I2C3_BASE + TRU_HPS_I2C_IC_ABRT_SOURCE_OFFSET)
+#define TRU_HPS_I2C3_IC_TX_ABRT_SOURCE_ADDR     (TRU_HPS_I2C3_BASE + TRU_HPS_I2C_IC_TX_ABRT_SOURCE_OFFSET)
 #define TRU_HPS_I2C3_IC_SLV_DATA_NACK_ONLY_ADDR (TRU_HPS_I2C3_BASE + TRU_HPS_I2C_IC_SLV_DATA_NACK_ONLY_OFFSET)
 #define TRU_HPS_I2C3_IC_DMA_CR_ADDR             (TRU_HPS_I2C3_BASE + TRU_HPS_I2C_IC_DMA_CR_OFFSET)
 #define TRU_HPS_I2C3_IC_SDA_SETUP_ADDR          (TRU_HPS_I2C3_BASE + TRU_HPS_I2C_IC_SDA_SETUP_OFFSET)
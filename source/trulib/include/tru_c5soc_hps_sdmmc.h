@@ -0,0 +1,48 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250209
+
+	Single block reads and writes on the SD card of the Cyclone V SoC HPS
+	SD/MMC controller, using hwlib's SD/MMC driver.
+*/
+
+#ifndef TRU_C5SOC_HPS_SDMMC_H
+#define TRU_C5SOC_HPS_SDMMC_H
+
+#include "tru_config.h"
+
+#if(TRU_TARGET == TRU_C5SOC)
+
+#include "alt_sdmmc.h"
+#include <stdint.h>
+
+#define TRU_HPS_SDMMC_BLOCK_SIZE 512U
+
+ALT_STATUS_CODE tru_hps_sdmmc_init(void);
+ALT_STATUS_CODE tru_hps_sdmmc_read_block(uint32_t block, uint32_t *buf);
+ALT_STATUS_CODE tru_hps_sdmmc_write_block(uint32_t block, const uint32_t *buf);
+
+#endif
+
+#endif
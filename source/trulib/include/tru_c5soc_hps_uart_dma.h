@@ -0,0 +1,55 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250118
+
+	DMA (PL330 DMA-330) transmit for the Cyclone V SoC HPS UART controller,
+	using the UART DMA handshake.
+*/
+
+#ifndef TRU_C5SOC_HPS_UART_DMA_H
+#define TRU_C5SOC_HPS_UART_DMA_H
+
+#include "tru_config.h"
+
+#if(TRU_TARGET == TRU_C5SOC)
+
+#include "tru_c5soc_hps_uart_ll.h"
+#include "alt_dma.h"
+#include <stdint.h>
+
+#ifndef TRU_HPS_UART_DMA_BUF_SIZE
+	#define TRU_HPS_UART_DMA_BUF_SIZE 256U  // Bytes per transmit buffer, a multiple of the cache line size
+#endif
+#define TRU_HPS_UART_DMA_BUF_ALIGN    32U
+
+ALT_STATUS_CODE tru_hps_uart_dma_init(TRU_TARGET_TYPE *uart_base, ALT_DMA_CHANNEL_t channel);
+uint8_t *tru_hps_uart_dma_next_buf(void);
+ALT_STATUS_CODE tru_hps_uart_dma_send(const uint8_t *buf, uint32_t len);
+ALT_STATUS_CODE tru_hps_uart_dma_write(const uint8_t *buf, uint32_t len);
+uint8_t tru_hps_uart_dma_busy(void);
+void tru_hps_uart_dma_wait(void);
+
+#endif
+
+#endif
@@ -42,11 +42,32 @@
 
 // HPS UART generic
 #define TRU_HPS_UART_RBR_THR_DLL_OFFSET 0x0U
+#define TRU_HPS_UART_IER_DLH_OFFSET     0x4U
+#define TRU_HPS_UART_IIR_FCR_OFFSET     0x8U
+#define TRU_HPS_UART_LCR_OFFSET         0xcU
 #define TRU_HPS_UART_LSR_OFFSET         0x14U
+#define TRU_HPS_UART_USR_OFFSET         0x7cU
 #define TRU_HPS_UART_SFE_OFFSET         0x98U
 #define TRU_HPS_UART_STET_OFFSET        0xa0U
+#define TRU_HPS_UART_IER_ETBEI_SET_MSK  0x00000002UL  // Transmit holding register empty interrupt enable
+#define TRU_HPS_UART_IER_PTIME_SET_MSK  0x00000080UL  // Programmable THRE interrupt mode enable
+#define TRU_HPS_UART_IIR_ID_MSK         0x0000000fUL
+#define TRU_HPS_UART_IIR_ID_THRE        0x2U
+#define TRU_HPS_UART_FCR_FIFOE_SET_MSK  0x00000001UL  // FIFO enable
+#define TRU_HPS_UART_FCR_DMAM_SET_MSK   0x00000008UL  // DMA mode 1, multi-transfer handshake
+#define TRU_HPS_UART_FCR_TET_POS        4U            // Transmit empty trigger, same values as STET
+#define TRU_HPS_UART_LCR_DLAB_SET_MSK   0x00000080UL  // Divisor latch access
+#define TRU_HPS_UART_LCR_8N1            0x03U         // 8 data bits, no parity, 1 stop bit
 #define TRU_HPS_UART_LSR_TEMT_SET_MSK   0x00000040UL
 #define TRU_HPS_UART_LSR_THRE_SET_MSK   0x00000020UL
+#define TRU_HPS_UART_USR_BUSY_SET_MSK   0x00000001UL  // LCR can't be written while busy
+#define TRU_HPS_UART_USR_TFNF_SET_MSK   0x00000002UL  // Transmit FIFO not full
+#define TRU_HPS_UART_SRR_RFR_SET_MSK    0x00000002UL  // Receive FIFO reset, the other FCR fields are kept
+#define TRU_HPS_UART_STET_EMPTY         0x0U          // Transmit empty trigger levels
+#define TRU_HPS_UART_STET_2CHARS        0x1U
+#define TRU_HPS_UART_STET_QUARTER       0x2U
+#define TRU_HPS_UART_STET_HALF          0x3U
+#define TRU_HPS_UART_FIFO_DEPTH         128U
 
 // HPS UART0 registers
 #define TRU_HPS_UART0_BASE              0xffc02000UL
@@ -96,13 +117,29 @@ typedef struct{
 	volatile uint32_t ctr;
 }tru_hps_uart_t;
 
+// Baud rate = clock / (16 * divisor), the divisor is 16 bits and has no
+// fractional part on this controller
+#define TRU_HPS_UART_DIVISOR_MAX       0xffffU
+#define TRU_HPS_UART_BAUD_MAX_ERR_PPM  25000  // Largest accepted rate error, +/-2.5%
+#define TRU_HPS_UART_BUSY_TIMEOUT      1000000U  // USR.BUSY polls before giving up, well over a character time at 9600 baud
+
+typedef struct{
+	uint32_t divisor;
+	uint32_t baud;     // Actual rate
+	int32_t err_ppm;   // Actual rate error from the requested rate, in parts per million
+}tru_hps_uart_baud_t;
+
 // UART registers as type representation
 #define TRU_HPS_UART0_REG ((volatile tru_hps_uart_t *const)TRU_HPS_UART0_BASE)
 #define TRU_HPS_UART1_REG ((volatile tru_hps_uart_t *const)TRU_HPS_UART1_BASE)
 #define TRU_HPS_UART_REG(base_addr) ((volatile tru_hps_uart_t *const)base_addr)
 
+void tru_hps_uart_ll_baud_calc(uint32_t clk_freq_hz, uint32_t baud, tru_hps_uart_baud_t *result);
+uint8_t tru_hps_uart_ll_config(TRU_TARGET_TYPE *uart_base, uint32_t clk_freq_hz, uint32_t baud, uint32_t lcr, tru_hps_uart_baud_t *result);
+uint32_t tru_hps_uart_ll_baud_readback(TRU_TARGET_TYPE *uart_base, uint32_t clk_freq_hz);
 void tru_hps_uart_ll_wait_empty(TRU_TARGET_TYPE *uart_base);
 void tru_hps_uart_ll_write_str(TRU_TARGET_TYPE *uart_base, const char *str, uint32_t len);
+void tru_hps_uart_ll_write_bin(TRU_TARGET_TYPE *uart_base, const uint8_t *buf, uint32_t len);
 void tru_hps_uart_ll_write_char(TRU_TARGET_TYPE *uart_base, const char c);
 void tru_hps_uart_ll_write_hex_nibble(TRU_TARGET_TYPE *uart_base, unsigned char nibble);
 void tru_hps_uart_ll_write_inthex(TRU_TARGET_TYPE *uart_base, int num, unsigned int bits);
@@ -0,0 +1,61 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250124
+
+	Interrupt driven transmit ring buffer for the Cyclone V SoC HPS UART
+	controller.
+*/
+
+#ifndef TRU_C5SOC_HPS_UART_TX_H
+#define TRU_C5SOC_HPS_UART_TX_H
+
+#include "tru_config.h"
+
+#if(TRU_TARGET == TRU_C5SOC)
+
+#include "tru_c5soc_hps_uart_ll.h"
+#include <stdint.h>
+
+// Ring buffer full policies for TRU_UART_TX_FULL
+#define TRU_HPS_UART_TX_FULL_DROP      0U
+#define TRU_HPS_UART_TX_FULL_BLOCK     1U
+#define TRU_HPS_UART_TX_FULL_OVERWRITE 2U
+
+typedef struct{
+	uint32_t dropped;     // Bytes dropped or overwritten because the ring was full
+	uint32_t high_water;  // Most bytes held in the ring
+}tru_hps_uart_tx_stats_t;
+
+void tru_hps_uart_tx_init(TRU_TARGET_TYPE *uart_base);
+uint8_t tru_hps_uart_tx_is_init(void);
+void tru_hps_uart_tx_write(const uint8_t *buf, uint32_t len);
+void tru_hps_uart_tx_write_str(const char *str, uint32_t len);
+void tru_hps_uart_tx_flush(void);
+uint32_t tru_hps_uart_tx_used(void);
+void tru_hps_uart_tx_get_stats(tru_hps_uart_tx_stats_t *stats);
+void tru_hps_uart_tx_irq_handler(void);
+
+#endif
+
+#endif
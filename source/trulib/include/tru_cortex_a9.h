@@ -21,7 +21,7 @@
 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 	SOFTWARE.
 
-	Version: 20241214
+	Version: 20250215
 
 	Arm Cortex-A9 low level assembly codes.
 */
@@ -96,6 +96,8 @@ typedef struct{
 #define GTIM_ISR_EVENTFLAG_POS 1U
 #define GTIM_ISR_EVENTFLAG_MSK 0x1U
 
+#define GTIM_IRQN 27U  // Global timer private peripheral interrupt (PPI) ID
+
 // Basic plain running timer mode: timer stopped, no compare, no interrupt, no auto-reset counter, no prescaler
 static inline void gtim_setup_basic_mode(void){
 	GTIM_REG->control &= ~(GTIM_CONTROL_ENABLE_MSK | GTIM_CONTROL_COMPARE_ENABLE_MSK | GTIM_CONTROL_IRQ_ENABLE_MSK | GTIM_CONTROL_AUTOINC_MSK | GTIM_CONTROL_PRESCALER_MSK);
@@ -133,4 +135,18 @@ static inline void gtim_set_counter(uint64_t counter){
 	GTIM_REG->counterh = (uint32_t)(counter >> 32U);
 }
 
+// Compare mode: raise the global timer interrupt when the counter reaches compare
+static inline void gtim_set_compare(uint64_t compare){
+	GTIM_REG->control &= ~(uint32_t)GTIM_CONTROL_COMPARE_ENABLE_MSK;
+	GTIM_REG->comparel = (uint32_t)compare;
+	GTIM_REG->compareh = (uint32_t)(compare >> 32U);
+	GTIM_REG->control |= GTIM_CONTROL_COMPARE_ENABLE_MSK | GTIM_CONTROL_IRQ_ENABLE_MSK;
+}
+
+// Compare mode off and clear the event flag
+static inline void gtim_clear_compare(void){
+	GTIM_REG->control &= ~(uint32_t)(GTIM_CONTROL_COMPARE_ENABLE_MSK | GTIM_CONTROL_IRQ_ENABLE_MSK);
+	GTIM_REG->isr = GTIM_ISR_EVENTFLAG_MSK;  // Write 1 to clear
+}
+
 #endif
@@ -0,0 +1,62 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250217
+
+	Deferred work: interrupt handlers post short items that the main loop
+	runs later with interrupts enabled, i.e. top and bottom halves.
+*/
+
+#ifndef TRU_DEFER_H
+#define TRU_DEFER_H
+
+#include "tru_config.h"
+
+#if(TRU_TARGET == TRU_C5SOC)
+
+#include <stdint.h>
+
+#ifndef TRU_DEFER_SIZE
+	#define TRU_DEFER_SIZE 8U  // Items the queue holds, a power of two
+#endif
+
+// A bottom half, arg and ticks as posted
+typedef void (*tru_defer_fn_t)(uint32_t arg, uint64_t ticks);
+
+typedef struct{
+	uint32_t posted;
+	uint32_t run;
+	uint32_t full;             // Posts refused because the queue was full
+	uint32_t high_water;       // Most items queued
+	uint32_t wait_max_ticks;   // Longest post to start of run, in global timer ticks
+	uint32_t run_max_ticks;    // Longest bottom half
+}tru_defer_stats_t;
+
+uint8_t tru_defer_post(tru_defer_fn_t fn, uint32_t arg, uint64_t ticks);
+uint32_t tru_defer_run(void);
+void tru_defer_wait(void);
+void tru_defer_get_stats(tru_defer_stats_t *stats);
+
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250207
+
+	Binary telemetry frames for streaming accelerometer samples.
+
+	Frame layout before encoding, all fields little-endian:
+		sync      u16  TRU_TELEMETRY_SYNC
+		seq       u16  frame sequence number, wraps
+		timestamp u32  time of the first sample in microseconds, wraps
+		n         u8   number of samples in this frame
+		flags     u8   TRU_TELEMETRY_FLAG_*
+		samples   n * (x i16, y i16, z i16)
+		crc       u16  CRC-16/CCITT-FALSE over all bytes above
+
+	A gap frame marks samples lost before the next frame.  It has n = 0, the
+	TRU_TELEMETRY_FLAG_GAP flag, the time of the first lost sample, and a
+	lost u32 count in place of the samples.
+
+	The frame is then COBS (Consistent Overhead Byte Stuffing) encoded and a
+	0x00 delimiter is appended, so a receiver can always resynchronise on the
+	next zero byte.  This header only depends on stdint.h so that host tools
+	can share the layout.
+*/
+
+#ifndef TRU_TELEMETRY_H
+#define TRU_TELEMETRY_H
+
+#include <stdint.h>
+
+#ifndef TRU_TELEMETRY_SAMPLES
+	#define TRU_TELEMETRY_SAMPLES   16U  // Samples per full frame, keep the raw frame under 254 bytes so COBS adds one byte only
+#endif
+
+#define TRU_TELEMETRY_SYNC          0xa345U
+#define TRU_TELEMETRY_HDR_SIZE      10U
+#define TRU_TELEMETRY_SAMPLE_SIZE   6U
+#define TRU_TELEMETRY_CRC_SIZE      2U
+#define TRU_TELEMETRY_RAW_SIZE(n)   (TRU_TELEMETRY_HDR_SIZE + (n) * TRU_TELEMETRY_SAMPLE_SIZE + TRU_TELEMETRY_CRC_SIZE)
+#define TRU_TELEMETRY_GAP_SIZE      (TRU_TELEMETRY_HDR_SIZE + 4U + TRU_TELEMETRY_CRC_SIZE)
+#define TRU_TELEMETRY_RAW_MAX       TRU_TELEMETRY_RAW_SIZE(TRU_TELEMETRY_SAMPLES)
+#define TRU_TELEMETRY_COBS_MAX(len) ((len) + (len) / 254U + 1U)                    // Worst case encoded length, without the delimiter
+#define TRU_TELEMETRY_FRAME_MAX     (TRU_TELEMETRY_COBS_MAX(TRU_TELEMETRY_RAW_MAX) + 1U)  // Encoded length plus the delimiter
+
+// Frame flags
+#define TRU_TELEMETRY_FLAG_SINGLETAP 0x01U
+#define TRU_TELEMETRY_FLAG_DOUBLETAP 0x02U
+#define TRU_TELEMETRY_FLAG_GAP       0x04U  // Gap frame, see above
+#define TRU_TELEMETRY_FLAG_FREEFALL  0x08U
+#define TRU_TELEMETRY_FLAG_SYNTHETIC 0x80U  // Samples are test data, not measurements
+
+typedef struct{
+	uint16_t seq;
+	uint8_t n;
+	uint8_t flags;
+	uint32_t timestamp;
+	uint8_t raw[TRU_TELEMETRY_RAW_MAX];
+	uint8_t *frame;                              // Encoded frame ready to send, may be pointed to another TRU_TELEMETRY_FRAME_MAX byte buffer after init
+	uint8_t frame_buf[TRU_TELEMETRY_FRAME_MAX];
+}tru_telemetry_t;
+
+void tru_telemetry_init(tru_telemetry_t *tm);
+void tru_telemetry_set_flags(tru_telemetry_t *tm, uint8_t flags);
+uint32_t tru_telemetry_add(tru_telemetry_t *tm, uint32_t timestamp, int16_t x, int16_t y, int16_t z);
+uint32_t tru_telemetry_flush(tru_telemetry_t *tm);
+uint32_t tru_telemetry_gap(tru_telemetry_t *tm, uint32_t timestamp, uint32_t lost);
+uint32_t tru_telemetry_cobs_encode(const uint8_t *src, uint32_t len, uint8_t *dst);
+
+#endif
@@ -0,0 +1,281 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250130
+
+	Interrupt driven non-blocking I2C transactions for the ADXL345.
+*/
+
+#include "tru_adxl345_async.h"
+#include "tru_adxl345_ll.h"
+#include "tru_c5soc_hps_i2c_ll.h"
+#include "RTE_Components.h"   // CMSIS
+#include CMSIS_device_header  // CMSIS
+
+#define TRU_ADXL345_ASYNC_TX_TL (TRU_HPS_I2C_TXFIFO_DEPTH / 2U)
+#define CPSR_I_MSK 0x80U
+
+static struct{
+	tru_adxl345_i2c_xfer_t *head;  // Oldest uncompleted transaction
+	tru_adxl345_i2c_xfer_t *tail;  // Newest transaction
+	tru_adxl345_i2c_xfer_t *tx;    // Transaction having its commands pushed
+	tru_adxl345_i2c_xfer_t *rx;    // Read transaction receiving data
+	uint32_t rx_pending;           // Read commands pushed but not yet received
+	uint32_t cmd_count;            // Total commands pushed (free running)
+	uint32_t cpsr;                 // Interrupt handler's CPSR, restored around the callbacks
+}tru_adxl345_async;
+
+// With nested interrupts a higher priority handler may submit while this
+// engine is running, so the queue and the controller are only touched with
+// IRQs masked on this CPU
+static uint32_t lock(void){
+	uint32_t cpsr = __get_CPSR();
+
+	__disable_irq();
+	return cpsr;
+}
+
+static void unlock(uint32_t cpsr){
+	if((cpsr & CPSR_I_MSK) == 0U) __enable_irq();
+}
+
+// Push as many commands as possible into the TXFIFO, from as many queued
+// transactions as fit, so they run back-to-back on the bus
+static void tru_adxl345_async_fill(void){
+	tru_adxl345_i2c_xfer_t *xfer;
+	tru_hps_i2c_ic_data_cmd_var_t data_cmd;
+
+	while((xfer = tru_adxl345_async.tx) != 0 && TRU_HPS_I2C0_IC_STATUS_REG->bits.tfnf){
+		data_cmd.val = 0;
+		data_cmd.bits.stop = (xfer->tx_count == xfer->len) ? TRU_HPS_I2C_DATA_CMD_ISSUE_STOP_YES : TRU_HPS_I2C_DATA_CMD_ISSUE_STOP_NO;
+		if(xfer->tx_count == 0){
+			// Send write command and register address
+			data_cmd.bits.cmd = TRU_HPS_I2C_DATA_CMD_MASTER_WRITE;
+			data_cmd.bits.dat = xfer->reg_addr;
+			data_cmd.bits.restart = (xfer->dir == TRU_ADXL345_I2C_XFER_READ) ? TRU_HPS_I2C_DATA_CMD_ISSUE_RESTART_YES : TRU_HPS_I2C_DATA_CMD_ISSUE_RESTART_NO;
+		}else if(xfer->dir == TRU_ADXL345_I2C_XFER_READ){
+			// Don't ask for more than the RXFIFO can hold
+			if(tru_adxl345_async.rx_pending >= TRU_HPS_I2C_RXFIFO_DEPTH) break;
+			data_cmd.bits.cmd = TRU_HPS_I2C_DATA_CMD_MASTER_READ;
+			tru_adxl345_async.rx_pending++;
+		}else{
+			data_cmd.bits.cmd = TRU_HPS_I2C_DATA_CMD_MASTER_WRITE;
+			data_cmd.bits.dat = xfer->buf[xfer->tx_count - 1];
+		}
+		TRU_HPS_I2C0_IC_DATA_CMD_REG->val = data_cmd.val;
+		tru_adxl345_async.cmd_count++;
+		xfer->tx_count++;
+
+		// All commands of this transaction pushed?
+		if(xfer->tx_count > xfer->len){
+			xfer->cmd_end = tru_adxl345_async.cmd_count;
+			tru_adxl345_async.tx = xfer->next;
+		}
+	}
+}
+
+// Move received data from the RXFIFO into the read transaction buffers
+static void tru_adxl345_async_drain(void){
+	tru_adxl345_i2c_xfer_t *xfer;
+
+	while(TRU_HPS_I2C0_IC_STATUS_REG->bits.rfne){
+		// Find the read transaction the data belongs to
+		xfer = tru_adxl345_async.rx;
+		while(xfer && (xfer->dir != TRU_ADXL345_I2C_XFER_READ || xfer->rx_count == xfer->len)) xfer = xfer->next;
+		tru_adxl345_async.rx = xfer;
+
+		if(xfer){
+			xfer->buf[xfer->rx_count] = TRU_HPS_I2C0_IC_DATA_CMD_REG->bits.dat;
+			xfer->rx_count++;
+		}else{
+			(void)TRU_HPS_I2C0_IC_DATA_CMD_REG->val;  // Not expected, discard
+		}
+		if(tru_adxl345_async.rx_pending) tru_adxl345_async.rx_pending--;
+	}
+}
+
+// Remove the head transaction and call its callback
+static void tru_adxl345_async_complete_head(uint8_t status){
+	tru_adxl345_i2c_xfer_t *xfer = tru_adxl345_async.head;
+
+	tru_adxl345_async.head = xfer->next;
+	if(tru_adxl345_async.head == 0) tru_adxl345_async.tail = 0;
+	if(tru_adxl345_async.rx == xfer) tru_adxl345_async.rx = xfer->next;
+	xfer->next = 0;
+	xfer->status = status;
+
+	// The queue is consistent here, so a callback runs with IRQs as they were
+	// and can take as long as it needs
+	if(xfer->callback){
+		unlock(tru_adxl345_async.cpsr);
+		xfer->callback(xfer);
+		(void)lock();
+	}
+}
+
+// Complete transactions in order
+static void tru_adxl345_async_retire(uint8_t stop_det){
+	tru_adxl345_i2c_xfer_t *xfer;
+	int32_t consumed;
+
+	while((xfer = tru_adxl345_async.head) != 0){
+		if(xfer->tx_count <= xfer->len) break;  // Commands not all pushed yet
+
+		if(xfer->dir == TRU_ADXL345_I2C_XFER_READ){
+			if(xfer->rx_count < xfer->len) break;
+		}else{
+			// A write is complete when all its commands have left the TXFIFO and
+			// either the stop was detected or the bus has moved on to the next one
+			consumed = (int32_t)(tru_adxl345_async.cmd_count - TRU_HPS_I2C0_IC_TXFLR_REG->bits.txflr - xfer->cmd_end);
+			if(consumed < 0) break;
+			if(consumed == 0 && !stop_det && TRU_HPS_I2C0_IC_STATUS_REG->bits.mst_activity) break;
+		}
+
+		tru_adxl345_async_complete_head(TRU_ADXL345_I2C_XFER_STATUS_DONE);
+	}
+}
+
+// Handle a transmit abort.  The controller has flushed the TXFIFO, so the
+// head transaction is reported as aborted and the rest are restarted
+static void tru_adxl345_async_abort(void){
+	tru_adxl345_i2c_xfer_t *xfer;
+	uint32_t abrt_source = TRU_HPS_I2C0_IC_TX_ABRT_SOURCE_REG->val;
+
+	// Discard any received data of the failed transactions
+	while(TRU_HPS_I2C0_IC_STATUS_REG->bits.rfne) (void)TRU_HPS_I2C0_IC_DATA_CMD_REG->val;
+
+	xfer = tru_adxl345_async.head;
+	if(xfer){
+		xfer->abrt_source = abrt_source;
+		for(tru_adxl345_i2c_xfer_t *x = xfer->next; x; x = x->next){
+			x->tx_count = 0;
+			x->rx_count = 0;
+		}
+		tru_adxl345_async.tx = xfer->next;
+		tru_adxl345_async.rx = xfer->next;
+	}
+	tru_adxl345_async.rx_pending = 0;
+
+	// Reading this releases the TXFIFO from the flushed state
+	(void)TRU_HPS_I2C0_IC_CLR_TX_ABRT_REG->val;
+
+	if(xfer) tru_adxl345_async_complete_head(TRU_ADXL345_I2C_XFER_STATUS_ABORTED);
+}
+
+// Set which interrupts are needed for the current state.  TX_EMPTY is a level
+// condition, so it is only unmasked while there are commands left to push
+static void tru_adxl345_async_update_mask(void){
+	tru_hps_i2c_ic_intr_mask_t mask = { .val = 0 };
+	uint32_t rx_tl;
+
+	if(tru_adxl345_async.head){
+		mask.bits.m_tx_abrt = 1;
+		mask.bits.m_stop_det = 1;
+		if(tru_adxl345_async.tx) mask.bits.m_tx_empty = 1;
+		if(tru_adxl345_async.rx_pending){
+			// Interrupt when all outstanding bytes have arrived or the RXFIFO is half full
+			rx_tl = (tru_adxl345_async.rx_pending < TRU_HPS_I2C_RXFIFO_DEPTH / 2U) ? tru_adxl345_async.rx_pending : TRU_HPS_I2C_RXFIFO_DEPTH / 2U;
+			TRU_HPS_I2C0_IC_RX_TL_REG->val = rx_tl - 1U;
+			mask.bits.m_rx_full = 1;
+		}
+	}
+	TRU_HPS_I2C0_IC_INTR_MASK_REG->val = mask.val;
+}
+
+static void tru_adxl345_async_service(uint8_t stop_det){
+	tru_adxl345_async_drain();
+	tru_adxl345_async_retire(stop_det);
+	tru_adxl345_async_fill();
+	tru_adxl345_async_update_mask();
+}
+
+// Prepare the engine.  Call after tru_adxl345_i2c_init(), then register
+// tru_adxl345_i2c_async_irq_handler() for the I2C0 interrupt.  It only drives
+// I2C0 and the device selected last, see tru_adxl345_i2c_select()
+void tru_adxl345_i2c_async_init(void){
+	TRU_HPS_I2C0_IC_INTR_MASK_REG->val = 0;
+	tru_adxl345_async.head = 0;
+	tru_adxl345_async.tail = 0;
+	tru_adxl345_async.tx = 0;
+	tru_adxl345_async.rx = 0;
+	tru_adxl345_async.rx_pending = 0;
+	tru_adxl345_async.cmd_count = 0;
+	TRU_HPS_I2C0_IC_TX_TL_REG->val = TRU_ADXL345_ASYNC_TX_TL;
+	TRU_HPS_I2C0_IC_RX_TL_REG->val = 0;
+	(void)TRU_HPS_I2C0_IC_CLR_INTR_REG->val;
+}
+
+// Queue a transaction.  Returns 0 on success or -1 if the descriptor is invalid
+// Can be called from a transaction callback to chain transactions
+int tru_adxl345_i2c_async_submit(tru_adxl345_i2c_xfer_t *xfer){
+	uint32_t cpsr;
+
+	if(xfer == 0 || (xfer->len && xfer->buf == 0) || (xfer->dir == TRU_ADXL345_I2C_XFER_READ && xfer->len == 0)) return -1;
+
+	xfer->status = TRU_ADXL345_I2C_XFER_STATUS_PENDING;
+	xfer->abrt_source = 0;
+	xfer->tx_count = 0;
+	xfer->rx_count = 0;
+	xfer->cmd_end = 0;
+	xfer->next = 0;
+	tru_adxl345_i2c_count(TRU_HPS_I2C0_BASE, xfer->dir == TRU_ADXL345_I2C_XFER_WRITE, 1, xfer->len);
+
+	cpsr = lock();
+	if(tru_adxl345_async.tail){
+		tru_adxl345_async.tail->next = xfer;
+	}else{
+		tru_adxl345_async.head = xfer;
+		tru_adxl345_async.rx = xfer;
+	}
+	tru_adxl345_async.tail = xfer;
+	if(tru_adxl345_async.tx == 0) tru_adxl345_async.tx = xfer;
+	if(tru_adxl345_async.rx == 0) tru_adxl345_async.rx = xfer;
+
+	// Start pushing now, the interrupts take over from here
+	tru_adxl345_async_fill();
+	tru_adxl345_async_update_mask();
+	unlock(cpsr);
+
+	return 0;
+}
+
+// Returns 1 if there are transactions in progress
+uint8_t tru_adxl345_i2c_async_busy(void){
+	return tru_adxl345_async.head != 0;
+}
+
+// I2C0 interrupt handler
+void tru_adxl345_i2c_async_irq_handler(void){
+	tru_hps_i2c_ic_intr_stat_t stat;
+	uint32_t cpsr = lock();
+
+	// Nothing for us, e.g. a submit after this was raised changed the mask
+	stat.val = TRU_HPS_I2C0_IC_INTR_STAT_REG->val;
+	if(stat.val){
+		tru_adxl345_async.cpsr = cpsr;
+		if(stat.bits.r_stop_det) (void)TRU_HPS_I2C0_IC_CLR_STOP_DET_REG->val;
+		if(stat.bits.r_tx_abrt) tru_adxl345_async_abort();
+		tru_adxl345_async_service(stat.bits.r_stop_det);
+	}
+	unlock(cpsr);
+}
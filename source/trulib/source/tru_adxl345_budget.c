@@ -0,0 +1,111 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250201
+
+	End-to-end time budget of the ADXL345 readout: bus time, CPU time and
+	output bytes per sample against the sample period, and how many sensors
+	at the same rate each resource could carry.
+*/
+
+#include "tru_adxl345_budget.h"
+
+void tru_adxl345_budget_init(tru_adxl345_budget_t *b, uint32_t tick_hz, uint32_t odr_mhz, uint32_t scl_hz, uint32_t uart_baud, uint64_t ticks, const tru_adxl345_i2c_stats_t *i2c_stats){
+	b->tick_hz = tick_hz;
+	b->odr_mhz = odr_mhz ? odr_mhz : 1U;
+	b->scl_hz = scl_hz ? scl_hz : 1U;
+	b->uart_bytes_hz = uart_baud / 10U;  // Start, 8 data and stop bits
+	if(b->uart_bytes_hz == 0) b->uart_bytes_hz = 1;
+	b->start_ticks = ticks;
+	b->i2c_start = *i2c_stats;
+	b->samples = 0;
+	b->wait_ticks = 0;
+	b->cpu_ticks = 0;
+	b->out_bytes = 0;
+}
+
+/*
+	Call after each drain.
+	n          : samples read
+	wait_ticks : CPU time blocked on bus transfers for the drain, 0 when they run by interrupt or DMA
+	cpu_ticks  : CPU time of the output of the drain
+	out_bytes  : output bytes of the drain
+*/
+void tru_adxl345_budget_drain(tru_adxl345_budget_t *b, uint32_t n, uint32_t wait_ticks, uint32_t cpu_ticks, uint32_t out_bytes){
+	b->samples += n;
+	b->wait_ticks += wait_ticks;
+	b->cpu_ticks += cpu_ticks;
+	b->out_bytes += out_bytes;
+}
+
+// x * mul / div, split so the product can't overflow for totals of long runs
+static uint64_t scale(uint64_t x, uint32_t mul, uint32_t div){
+	return (x / div) * mul + (x % div) * mul / div;
+}
+
+static uint32_t pct(uint64_t cost, uint64_t period){
+	return (uint32_t)(cost * 100U / period);
+}
+
+static uint32_t fits(uint64_t cost, uint64_t period){
+	return cost ? (uint32_t)(period / cost) : 0;
+}
+
+void tru_adxl345_budget_get_report(const tru_adxl345_budget_t *b, uint64_t ticks, const tru_adxl345_i2c_stats_t *i2c_stats, tru_adxl345_budget_report_t *report){
+	uint64_t elapsed = ticks - b->start_ticks;
+	uint64_t elapsed_us;
+	uint64_t samples = b->samples ? b->samples : 1U;
+	uint64_t bits;
+	uint32_t max;
+
+	// Bits on the bus since the start, which include the FIFO_STATUS polls and
+	// INT_SOURCE reads.  The gaps between transactions aren't counted, so the
+	// bus load is a floor
+	bits = (uint64_t)(i2c_stats->reads - b->i2c_start.reads) * TRU_ADXL345_BUDGET_READ_BITS;
+	bits += (uint64_t)(i2c_stats->writes - b->i2c_start.writes) * TRU_ADXL345_BUDGET_WRITE_BITS;
+	bits += (uint64_t)(i2c_stats->read_bytes - b->i2c_start.read_bytes) * 9U;
+	bits += (uint64_t)(i2c_stats->write_bytes - b->i2c_start.write_bytes) * 9U;
+
+	report->samples = b->samples;
+	elapsed_us = scale(elapsed, 1000000U, b->tick_hz);
+	report->odr_mhz = elapsed_us ? (uint32_t)((uint64_t)b->samples * 1000000000U / elapsed_us) : 0;
+	report->period_ns = (uint32_t)(1000000000000ULL / b->odr_mhz);
+	report->bus_ns = (uint32_t)(scale(bits, 1000000000U, b->scl_hz) / samples);
+	report->wait_ns = (uint32_t)(scale(b->wait_ticks, 1000000000U, b->tick_hz) / samples);
+	report->cpu_ns = (uint32_t)(scale(b->cpu_ticks, 1000000000U, b->tick_hz) / samples);
+	report->out_bytes_x100 = (uint32_t)(b->out_bytes * 100U / samples);
+
+	report->bus_pct = pct(report->bus_ns, report->period_ns);
+	report->cpu_pct = pct((uint64_t)report->wait_ns + report->cpu_ns, report->period_ns);
+	report->uart_pct = (uint32_t)((uint64_t)report->out_bytes_x100 * b->odr_mhz / 1000U / b->uart_bytes_hz);
+
+	// Headroom is what the busiest resource leaves
+	max = report->bus_pct;
+	if(report->cpu_pct > max) max = report->cpu_pct;
+	if(report->uart_pct > max) max = report->uart_pct;
+	report->headroom_pct = (max < 100U) ? 100U - max : 0;
+
+	report->sensors_bus = fits(report->bus_ns, report->period_ns);
+	report->sensors_cpu = fits((uint64_t)report->wait_ns + report->cpu_ns, report->period_ns);
+	report->sensors_uart = fits((uint64_t)report->out_bytes_x100 * b->odr_mhz, (uint64_t)b->uart_bytes_hz * 100000U);
+}
@@ -0,0 +1,142 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250209
+
+	ADXL345 offset calibration: averages samples taken at rest, computes the
+	OFSX, OFSY and OFSZ register values and the residual error, and packs
+	the result into a record for persistent storage.
+*/
+
+#include "tru_adxl345_cal.h"
+#include "tru_crc.h"
+
+// Rounds a / b to the nearest, halves away from zero.  b > 0
+static int32_t div_round(int64_t a, int64_t b){
+	return (int32_t)(a >= 0 ? (a + b / 2) / b : -((-a + b / 2) / b));
+}
+
+void tru_adxl345_cal_init(tru_adxl345_cal_t *cal, tru_adxl345_data_format_t data_format, uint8_t up){
+	// 256 LSB/g at full resolution in any range, else 256, 128, 64 or 32
+	cal->lsb_per_g = data_format.bits.fullres ? 256U : 256U >> data_format.bits.range;
+	cal->up = up;
+	tru_adxl345_cal_reset(cal);
+}
+
+void tru_adxl345_cal_reset(tru_adxl345_cal_t *cal){
+	cal->sum[0] = 0;
+	cal->sum[1] = 0;
+	cal->sum[2] = 0;
+	cal->n = 0;
+}
+
+// Adds a sample, x, y and z as read from DATAX0 to DATAZ1
+void tru_adxl345_cal_add(tru_adxl345_cal_t *cal, const int16_t *xyz){
+	cal->sum[0] += xyz[0];
+	cal->sum[1] += xyz[1];
+	cal->sum[2] += xyz[2];
+	cal->n++;
+}
+
+// Mean error of an axis (0 = x, 1 = y, 2 = z) against rest, in micro g.  At
+// rest the up axis sees 1 g and the other two 0 g
+int32_t tru_adxl345_cal_error_ug(const tru_adxl345_cal_t *cal, uint32_t axis){
+	int64_t expect = 0;
+
+	if(cal->n == 0) return 0;
+	if(cal->up / 2U == axis) expect = (cal->up & 1U) ? -(int64_t)cal->lsb_per_g : (int64_t)cal->lsb_per_g;
+
+	return div_round(((int64_t)cal->sum[axis] - expect * cal->n) * 1000000, (int64_t)cal->lsb_per_g * cal->n);
+}
+
+// New offset register value for an axis, given the value in use while sampling.
+// The offset steps don't depend on the range, so the error is rounded from
+// micro g.  The error left after the offset in use is removed from it, so a
+// calibration can be repeated to refine it
+int8_t tru_adxl345_cal_offset(const tru_adxl345_cal_t *cal, uint32_t axis, int8_t ofs){
+	int32_t new_ofs = ofs - div_round(tru_adxl345_cal_error_ug(cal, axis), TRU_ADXL345_CAL_OFS_UG);
+
+	if(new_ofs < -128) new_ofs = -128;
+	if(new_ofs > 127) new_ofs = 127;
+	return (int8_t)new_ofs;
+}
+
+static void put_u16(uint8_t *buf, uint16_t v){
+	buf[0] = (uint8_t)v;
+	buf[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *buf, uint32_t v){
+	put_u16(buf, (uint16_t)v);
+	put_u16(buf + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_u16(const uint8_t *buf){
+	return (uint16_t)(buf[0] | (buf[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *buf){
+	return get_u16(buf) | ((uint32_t)get_u16(buf + 2) << 16);
+}
+
+// Packs a record into buf, returns its size.  Little-endian, the CRC is
+// CRC-16/CCITT-FALSE over the bytes before it
+uint32_t tru_adxl345_cal_pack(const tru_adxl345_cal_record_t *rec, uint8_t *buf){
+	put_u32(&buf[0], TRU_ADXL345_CAL_MAGIC);
+	put_u16(&buf[4], TRU_ADXL345_CAL_VERSION);
+	put_u16(&buf[6], rec->samples);
+	put_u32(&buf[8], rec->count);
+	buf[12] = rec->up;
+	buf[13] = rec->range;
+	buf[14] = (uint8_t)rec->ofs[0];
+	buf[15] = (uint8_t)rec->ofs[1];
+	buf[16] = (uint8_t)rec->ofs[2];
+	buf[17] = 0;
+	put_u32(&buf[18], (uint32_t)rec->residual_ug[0]);
+	put_u32(&buf[22], (uint32_t)rec->residual_ug[1]);
+	put_u32(&buf[26], (uint32_t)rec->residual_ug[2]);
+	put_u16(&buf[30], tru_crc16(buf, TRU_ADXL345_CAL_RECORD_SIZE - 2U));
+
+	return TRU_ADXL345_CAL_RECORD_SIZE;
+}
+
+// Unpacks a record from buf, returns 1 if it holds a valid record, else 0 and
+// rec is unchanged
+uint8_t tru_adxl345_cal_unpack(tru_adxl345_cal_record_t *rec, const uint8_t *buf){
+	if(get_u32(&buf[0]) != TRU_ADXL345_CAL_MAGIC) return 0;
+	if(get_u16(&buf[4]) != TRU_ADXL345_CAL_VERSION) return 0;
+	if(tru_crc16(buf, TRU_ADXL345_CAL_RECORD_SIZE - 2U) != get_u16(&buf[30])) return 0;
+
+	rec->samples = get_u16(&buf[6]);
+	rec->count = get_u32(&buf[8]);
+	rec->up = buf[12];
+	rec->range = buf[13];
+	rec->ofs[0] = (int8_t)buf[14];
+	rec->ofs[1] = (int8_t)buf[15];
+	rec->ofs[2] = (int8_t)buf[16];
+	rec->residual_ug[0] = (int32_t)get_u32(&buf[18]);
+	rec->residual_ug[1] = (int32_t)get_u32(&buf[22]);
+	rec->residual_ug[2] = (int32_t)get_u32(&buf[26]);
+
+	return 1;
+}
@@ -0,0 +1,185 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250130
+
+	ADXL345 configuration as one register image, applied with burst writes of
+	only the registers that changed, and a driver shadow of the writable
+	registers.
+*/
+
+#include "tru_adxl345_cfg.h"
+
+#define REG(addr) ((addr) - TRU_ADXL345_CFG_FIRST_ADDR)
+
+static uint8_t writable(uint32_t i){
+	if(i == REG(TRU_ADXL345_ACT_TAP_STATUS_ADDR) || i == REG(TRU_ADXL345_INT_SOURCE_ADDR)) return 0;
+	if(i >= REG(TRU_ADXL345_DATAX0_ADDR) && i <= REG(TRU_ADXL345_DATAZ1_ADDR)) return 0;
+	return 1;
+}
+
+// Power on reset values, see the ADXL345 register map
+void tru_adxl345_config_reset(tru_adxl345_config_t *cfg){
+	uint8_t *c = (uint8_t *)cfg;
+
+	for(uint32_t i = 0; i < TRU_ADXL345_CFG_SIZE; i++) c[i] = 0;
+	cfg->bw_rate.bits.rate = TRU_ADXL345_RATE_100_HZ;
+}
+
+// Reads the writable registers from the device.  INT_SOURCE and the data
+// registers are skipped, reading them clears events and pops the FIFO
+void tru_adxl345_config_read(tru_adxl345_dev_t *dev, tru_adxl345_config_t *cfg){
+	uint8_t *c = (uint8_t *)cfg;
+
+	tru_adxl345_i2c_read(dev, c, REG(TRU_ADXL345_INT_MAP_ADDR) + 1U, TRU_ADXL345_CFG_FIRST_ADDR);
+	tru_adxl345_i2c_read(dev, &c[REG(TRU_ADXL345_DATA_FORMAT_ADDR)], 1, TRU_ADXL345_DATA_FORMAT_ADDR);
+	tru_adxl345_i2c_read(dev, &c[REG(TRU_ADXL345_FIFO_CTL_ADDR)], 1, TRU_ADXL345_FIFO_CTL_ADDR);
+	cfg->act_tap_status.val = 0;
+	cfg->int_source.val = 0;
+	for(uint32_t i = 0; i < sizeof(cfg->data); i++) cfg->data[i] = 0;
+}
+
+/*
+	Writes the registers of next that differ from cur, and updates cur.
+	Returns the number of I2C write transactions used.
+	Each run of changes is one multi-byte write, the ADXL345 increments the
+	address after each byte.  Setting the measure bit starts sampling, so
+	POWER_CTL is written last when it turns measuring on.
+*/
+uint32_t tru_adxl345_config_apply(tru_adxl345_dev_t *dev, tru_adxl345_config_t *cur, const tru_adxl345_config_t *next){
+	uint8_t *c = (uint8_t *)cur;
+	const uint8_t *n = (const uint8_t *)next;
+	const uint32_t power = REG(TRU_ADXL345_POWER_CTL_ADDR);
+	uint8_t power_last = (next->power_ctl.bits.measure && !cur->power_ctl.bits.measure);
+	uint32_t writes = 0;
+	uint32_t i = 0;
+	uint32_t j;
+	uint32_t end;
+
+	#define CHANGED(k) (writable(k) && c[k] != n[k] && !((k) == power && power_last))
+
+	while(i < TRU_ADXL345_CFG_SIZE){
+		if(!CHANGED(i)){
+			i++;
+			continue;
+		}
+
+		// Extend the run to the last change within bridging distance, the
+		// unchanged registers in between are rewritten with their value
+		end = i;
+		for(j = i + 1U; j < TRU_ADXL345_CFG_SIZE && writable(j) && !(j == power && power_last); j++){
+			if(CHANGED(j)){
+				end = j;
+			}else if(j - end > TRU_ADXL345_CFG_BRIDGE){
+				break;
+			}
+		}
+
+		tru_adxl345_i2c_write(dev, (void *)&n[i], end - i + 1U, TRU_ADXL345_CFG_FIRST_ADDR + i);
+		for(j = i; j <= end; j++) c[j] = n[j];
+		writes++;
+		i = end + 1U;
+	}
+
+	if(power_last){
+		tru_adxl345_i2c_write(dev, (void *)&n[power], 1, TRU_ADXL345_POWER_CTL_ADDR);
+		c[power] = n[power];
+		writes++;
+	}
+
+	#undef CHANGED
+
+	return writes;
+}
+
+static uint8_t *shadow_reg(tru_adxl345_dev_t *dev, uint32_t addr){
+	if(addr < TRU_ADXL345_CFG_FIRST_ADDR || addr >= TRU_ADXL345_CFG_FIRST_ADDR + TRU_ADXL345_CFG_SIZE) return 0;
+	if(!writable(REG(addr))) return 0;
+	return &((uint8_t *)&dev->shadow)[REG(addr)];
+}
+
+// Loads the shadow from the device, call once after the I2C init
+void tru_adxl345_shadow_load(tru_adxl345_dev_t *dev){
+	tru_adxl345_config_read(dev, &dev->device);
+	dev->shadow = dev->device;
+	dev->shadow_stats.hits = 0;
+	dev->shadow_stats.flushes = 0;
+}
+
+// The shadow image, change its members and then call tru_adxl345_shadow_flush()
+tru_adxl345_config_t *tru_adxl345_shadow(tru_adxl345_dev_t *dev){
+	return &dev->shadow;
+}
+
+// Reads a register, from the shadow if it is writable (including changes not
+// flushed yet), else from the device.  INT_SOURCE, FIFO_STATUS and the data
+// registers change on their own, so they always go on the bus
+uint8_t tru_adxl345_reg_read(tru_adxl345_dev_t *dev, uint32_t addr){
+	uint8_t *reg = shadow_reg(dev, addr);
+	uint8_t val;
+
+	if(reg){
+		dev->shadow_stats.hits++;
+		return *reg;
+	}
+	tru_adxl345_i2c_read(dev, &val, 1, addr);
+
+	return val;
+}
+
+// Sets a writable register in the shadow
+void tru_adxl345_reg_write(tru_adxl345_dev_t *dev, uint32_t addr, uint8_t val){
+	uint8_t *reg = shadow_reg(dev, addr);
+
+	if(reg) *reg = val;
+}
+
+// Sets the bits in mask of a writable register in the shadow to those of val
+void tru_adxl345_reg_update(tru_adxl345_dev_t *dev, uint32_t addr, uint8_t mask, uint8_t val){
+	uint8_t *reg = shadow_reg(dev, addr);
+
+	if(reg) *reg = (uint8_t)((*reg & ~mask) | (val & mask));
+}
+
+// Writes the shadow registers that differ from the device.  Returns the number
+// of I2C write transactions used
+uint32_t tru_adxl345_shadow_flush(tru_adxl345_dev_t *dev){
+	uint32_t writes = tru_adxl345_config_apply(dev, &dev->device, &dev->shadow);
+
+	if(writes) dev->shadow_stats.flushes++;
+	return writes;
+}
+
+// Records registers written to the device by other means, e.g. a non-blocking
+// transaction of the shadow values, so they are not flushed again
+void tru_adxl345_shadow_written(tru_adxl345_dev_t *dev, uint32_t addr, uint32_t len){
+	for(uint32_t i = 0; i < len; i++){
+		uint8_t *reg = shadow_reg(dev, addr + i);
+
+		if(reg) ((uint8_t *)&dev->device)[REG(addr + i)] = *reg;
+	}
+}
+
+void tru_adxl345_shadow_get_stats(tru_adxl345_dev_t *dev, tru_adxl345_shadow_stats_t *stats){
+	*stats = dev->shadow_stats;
+}
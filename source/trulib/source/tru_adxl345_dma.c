@@ -0,0 +1,259 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250130
+
+	DMA (PL330 DMA-330) readout of the ADXL345 FIFO using the HPS I2C0
+	controller.
+*/
+
+#include "tru_adxl345_dma.h"
+#include "tru_adxl345_ll.h"
+#include "tru_c5soc_hps_i2c_ll.h"
+#include "alt_dma_program.h"
+#include "alt_cache.h"
+#include "RTE_Components.h"   // CMSIS
+#include CMSIS_device_header  // CMSIS
+
+#define TRU_ADXL345_DMA_CMDS_PER_ENTRY 7U  // Write DATAX0 address, 5 reads, read with stop
+#define CPSR_I_MSK 0x80U
+
+static uint32_t tru_adxl345_dma_cmd[TRU_ADXL345_DMA_BUF_ALIGN / sizeof(uint32_t)] __attribute__((aligned(TRU_ADXL345_DMA_BUF_ALIGN)));
+
+static struct{
+	ALT_DMA_CHANNEL_t tx_channel;
+	ALT_DMA_CHANNEL_t rx_channel;
+	ALT_DMA_EVENT_t evt;
+	ALT_DMA_PROGRAM_t tx_program;
+	ALT_DMA_PROGRAM_t rx_program;
+	void *buf;
+	uint32_t n;
+	tru_adxl345_dma_cb_t callback;
+	volatile uint8_t busy;
+}tru_adxl345_dma;
+
+// With nested interrupts a higher priority handler may start a drain while
+// the DMA handler is running, so the state is only touched with IRQs masked on
+// this CPU
+static uint32_t lock(void){
+	uint32_t cpsr = __get_CPSR();
+
+	__disable_irq();
+	return cpsr;
+}
+
+static void unlock(uint32_t cpsr){
+	if((cpsr & CPSR_I_MSK) == 0U) __enable_irq();
+}
+
+// Build the command table for reading one FIFO entry, the TX program sends it
+// once per entry
+static void tru_adxl345_dma_init_cmd(void){
+	tru_hps_i2c_ic_data_cmd_var_t data_cmd = { .val = 0 };
+
+	data_cmd.bits.cmd = TRU_HPS_I2C_DATA_CMD_MASTER_WRITE;
+	data_cmd.bits.dat = TRU_ADXL345_DATAX0_ADDR;
+	data_cmd.bits.restart = TRU_HPS_I2C_DATA_CMD_ISSUE_RESTART_YES;
+	data_cmd.bits.stop = TRU_HPS_I2C_DATA_CMD_ISSUE_STOP_NO;
+	tru_adxl345_dma_cmd[0] = data_cmd.val;
+
+	data_cmd.bits.cmd = TRU_HPS_I2C_DATA_CMD_MASTER_READ;
+	data_cmd.bits.dat = 0;
+	data_cmd.bits.restart = TRU_HPS_I2C_DATA_CMD_ISSUE_RESTART_NO;
+	for(uint32_t i = 1; i < TRU_ADXL345_DMA_CMDS_PER_ENTRY - 1; i++) tru_adxl345_dma_cmd[i] = data_cmd.val;
+
+	data_cmd.bits.stop = TRU_HPS_I2C_DATA_CMD_ISSUE_STOP_YES;
+	tru_adxl345_dma_cmd[TRU_ADXL345_DMA_CMDS_PER_ENTRY - 1] = data_cmd.val;
+
+	// Make the table visible to the DMA controller
+	alt_cache_system_clean(tru_adxl345_dma_cmd, sizeof(tru_adxl345_dma_cmd));
+}
+
+// The programs are built here because hwlib's alt_dma_memory_to_periph() and
+// alt_dma_periph_to_memory() only do one I2C transaction per program.  They
+// are only rebuilt when the buffer or entry count changes
+
+// TX program: N x 7 command words to IC_DATA_CMD
+static ALT_STATUS_CODE tru_adxl345_dma_build_tx(uint32_t n){
+	ALT_DMA_PROGRAM_t *pgm = &tru_adxl345_dma.tx_program;
+	ALT_STATUS_CODE status;
+
+	status = alt_dma_program_init(pgm);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMAMOV(pgm, ALT_DMA_PROGRAM_REG_CCR,
+		ALT_DMA_CCR_OPT_SAI | ALT_DMA_CCR_OPT_SS32 | ALT_DMA_CCR_OPT_SB1 | ALT_DMA_CCR_OPT_SP_DEFAULT | ALT_DMA_CCR_OPT_SC_DEFAULT |
+		ALT_DMA_CCR_OPT_DAF | ALT_DMA_CCR_OPT_DS32 | ALT_DMA_CCR_OPT_DB1 | ALT_DMA_CCR_OPT_DP_DEFAULT | ALT_DMA_CCR_OPT_DC_DEFAULT |
+		ALT_DMA_CCR_OPT_ES_DEFAULT);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMAMOV(pgm, ALT_DMA_PROGRAM_REG_DAR, (uint32_t)TRU_HPS_I2C0_IC_DATA_CMD_ADDR);
+	if(status == ALT_E_SUCCESS && n > 1) status = alt_dma_program_DMALP(pgm, n);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMAMOV(pgm, ALT_DMA_PROGRAM_REG_SAR, (uint32_t)tru_adxl345_dma_cmd);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMALP(pgm, TRU_ADXL345_DMA_CMDS_PER_ENTRY);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMAFLUSHP(pgm, ALT_DMA_PERIPH_I2C0_TX);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMAWFP(pgm, ALT_DMA_PERIPH_I2C0_TX, ALT_DMA_PROGRAM_INST_MOD_SINGLE);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMALD(pgm, ALT_DMA_PROGRAM_INST_MOD_SINGLE);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMAST(pgm, ALT_DMA_PROGRAM_INST_MOD_SINGLE);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMALPEND(pgm, ALT_DMA_PROGRAM_INST_MOD_NONE);
+	if(status == ALT_E_SUCCESS && n > 1) status = alt_dma_program_DMALPEND(pgm, ALT_DMA_PROGRAM_INST_MOD_NONE);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMAEND(pgm);
+
+	return status;
+}
+
+// RX program: N x 6 data bytes from IC_DATA_CMD to the buffer, then signal
+static ALT_STATUS_CODE tru_adxl345_dma_build_rx(void *buf, uint32_t n){
+	ALT_DMA_PROGRAM_t *pgm = &tru_adxl345_dma.rx_program;
+	ALT_STATUS_CODE status;
+
+	status = alt_dma_program_init(pgm);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMAMOV(pgm, ALT_DMA_PROGRAM_REG_CCR,
+		ALT_DMA_CCR_OPT_SAF | ALT_DMA_CCR_OPT_SS8 | ALT_DMA_CCR_OPT_SB1 | ALT_DMA_CCR_OPT_SP_DEFAULT | ALT_DMA_CCR_OPT_SC_DEFAULT |
+		ALT_DMA_CCR_OPT_DAI | ALT_DMA_CCR_OPT_DS8 | ALT_DMA_CCR_OPT_DB1 | ALT_DMA_CCR_OPT_DP_DEFAULT | ALT_DMA_CCR_OPT_DC_DEFAULT |
+		ALT_DMA_CCR_OPT_ES_DEFAULT);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMAMOV(pgm, ALT_DMA_PROGRAM_REG_SAR, (uint32_t)TRU_HPS_I2C0_IC_DATA_CMD_ADDR);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMAMOV(pgm, ALT_DMA_PROGRAM_REG_DAR, (uint32_t)buf);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMALP(pgm, n);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMALP(pgm, TRU_ADXL345_DMA_ENTRY_SIZE);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMAFLUSHP(pgm, ALT_DMA_PERIPH_I2C0_RX);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMAWFP(pgm, ALT_DMA_PERIPH_I2C0_RX, ALT_DMA_PROGRAM_INST_MOD_SINGLE);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMALD(pgm, ALT_DMA_PROGRAM_INST_MOD_SINGLE);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMAST(pgm, ALT_DMA_PROGRAM_INST_MOD_SINGLE);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMALPEND(pgm, ALT_DMA_PROGRAM_INST_MOD_NONE);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMALPEND(pgm, ALT_DMA_PROGRAM_INST_MOD_NONE);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMAWMB(pgm);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMASEV(pgm, tru_adxl345_dma.evt);
+	if(status == ALT_E_SUCCESS) status = alt_dma_program_DMAEND(pgm);
+
+	return status;
+}
+
+// Allocate the two channels.  The I2C0 DMA requests are hard wired, so only
+// I2C0 is supported, and it talks to the device selected last, see
+// tru_adxl345_i2c_select().  The DMA controller must already be initialised
+// with alt_dma_init().  Register tru_adxl345_dma_irq_handler() for the DMA
+// interrupt matching evt (e.g. ALT_DMA_EVENT_0 = C5SOC_DMA0_IRQn)
+ALT_STATUS_CODE tru_adxl345_dma_init(ALT_DMA_CHANNEL_t tx_channel, ALT_DMA_CHANNEL_t rx_channel, ALT_DMA_EVENT_t evt){
+	ALT_STATUS_CODE status;
+
+	status = alt_dma_channel_alloc(tx_channel);
+	if(status == ALT_E_SUCCESS) status = alt_dma_channel_alloc(rx_channel);
+	if(status == ALT_E_SUCCESS) status = alt_dma_event_int_select(evt, ALT_DMA_EVENT_SELECT_SIG_IRQ);
+	if(status != ALT_E_SUCCESS) return status;
+
+	tru_adxl345_dma.tx_channel = tx_channel;
+	tru_adxl345_dma.rx_channel = rx_channel;
+	tru_adxl345_dma.evt = evt;
+	tru_adxl345_dma.buf = 0;
+	tru_adxl345_dma.n = 0;
+	tru_adxl345_dma.busy = 0;
+	tru_adxl345_dma_init_cmd();
+
+	// DMA request levels: TX request while the TXFIFO is at most half full,
+	// RX request as soon as there is a byte
+	TRU_HPS_I2C0_IC_DMA_TDLR_REG->bits.dmatdl = TRU_HPS_I2C_TXFIFO_DEPTH / 2U;
+	TRU_HPS_I2C0_IC_DMA_RDLR_REG->bits.dmardl = 0;
+
+	return ALT_E_SUCCESS;
+}
+
+// Call with IRQs masked
+static ALT_STATUS_CODE tru_adxl345_dma_start(void *buf, uint32_t n, tru_adxl345_dma_cb_t callback){
+	ALT_STATUS_CODE status = ALT_E_SUCCESS;
+
+	if(tru_adxl345_dma.busy) return ALT_E_ERROR;
+
+	// Only rebuild the programs if the request has changed
+	if(buf != tru_adxl345_dma.buf || n != tru_adxl345_dma.n){
+		status = tru_adxl345_dma_build_tx(n);
+		if(status == ALT_E_SUCCESS) status = tru_adxl345_dma_build_rx(buf, n);
+		if(status != ALT_E_SUCCESS){
+			tru_adxl345_dma.buf = 0;
+			return status;
+		}
+		tru_adxl345_dma.buf = buf;
+		tru_adxl345_dma.n = n;
+	}
+	tru_adxl345_dma.callback = callback;
+	tru_adxl345_dma.busy = 1;
+	tru_adxl345_i2c_count(TRU_HPS_I2C0_BASE, 0, n, n * TRU_ADXL345_DMA_ENTRY_SIZE);
+
+	// Drop any stale cache lines so they can't be written back over the DMA data
+	alt_cache_system_invalidate(buf, TRU_ADXL345_DMA_BUF_SIZE(n));
+
+	// Enable the I2C0 DMA handshaking, start RX first so it is ready for the first byte
+	TRU_HPS_I2C0_IC_DMA_CR_REG->bits.rdmae = 1;
+	TRU_HPS_I2C0_IC_DMA_CR_REG->bits.tdmae = 1;
+	status = alt_dma_channel_exec(tru_adxl345_dma.rx_channel, &tru_adxl345_dma.rx_program);
+	if(status == ALT_E_SUCCESS) status = alt_dma_channel_exec(tru_adxl345_dma.tx_channel, &tru_adxl345_dma.tx_program);
+	if(status != ALT_E_SUCCESS) tru_adxl345_dma_cancel();
+
+	return status;
+}
+
+// Start reading n FIFO entries (1 to TRU_ADXL345_FIFO_DEPTH) into buf, which
+// must be TRU_ADXL345_DMA_BUF_ALIGN aligned and TRU_ADXL345_DMA_BUF_SIZE(n)
+// bytes.  The callback is called from the DMA interrupt when done.  The
+// blocking and interrupt driven I2C functions must not be used meanwhile
+ALT_STATUS_CODE tru_adxl345_dma_fifo_drain(void *buf, uint32_t n, tru_adxl345_dma_cb_t callback){
+	ALT_STATUS_CODE status;
+	uint32_t cpsr;
+
+	if(buf == 0 || n == 0 || n > TRU_ADXL345_FIFO_DEPTH || ((uint32_t)buf & (TRU_ADXL345_DMA_BUF_ALIGN - 1U))) return ALT_E_BAD_ARG;
+
+	cpsr = lock();
+	status = tru_adxl345_dma_start(buf, n, callback);
+	unlock(cpsr);
+
+	return status;
+}
+
+// Returns 1 if a drain is in progress
+uint8_t tru_adxl345_dma_busy(void){
+	return tru_adxl345_dma.busy;
+}
+
+// Stop a drain, e.g. after a timeout
+void tru_adxl345_dma_cancel(void){
+	alt_dma_channel_kill(tru_adxl345_dma.tx_channel);
+	alt_dma_channel_kill(tru_adxl345_dma.rx_channel);
+	TRU_HPS_I2C0_IC_DMA_CR_REG->val = 0;
+	tru_adxl345_dma.busy = 0;
+}
+
+// DMA event interrupt handler
+void tru_adxl345_dma_irq_handler(void){
+	uint32_t cpsr = lock();
+	void *buf = tru_adxl345_dma.buf;
+	uint32_t n = tru_adxl345_dma.n;
+	tru_adxl345_dma_cb_t callback = tru_adxl345_dma.callback;
+
+	alt_dma_int_clear(tru_adxl345_dma.evt);
+	TRU_HPS_I2C0_IC_DMA_CR_REG->val = 0;
+
+	// Discard lines the CPU may have speculatively fetched during the transfer
+	alt_cache_system_invalidate(buf, TRU_ADXL345_DMA_BUF_SIZE(n));
+
+	tru_adxl345_dma.busy = 0;
+	unlock(cpsr);
+
+	// A drain started from here on can't change what this callback is given
+	if(callback) callback(buf, n);
+}
@@ -0,0 +1,157 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250203
+
+	Event capture with the ADXL345 FIFO trigger mode: the FIFO keeps a
+	history of samples, a tap or activity interrupt freezes it, and the
+	samples from before and after the trigger are collected into a
+	timestamped event record.
+*/
+
+#include "tru_adxl345_event.h"
+#include "tru_adxl345_cfg.h"
+#include "tru_cortex_a9.h"
+
+#define ENTRY_SIZE 6U
+
+/*
+	pre          : samples kept from before the trigger, 1 to 31
+	post         : samples wanted after the trigger
+	trigger_mask : INT_SOURCE bits that trigger, e.g. single tap and activity
+*/
+void tru_adxl345_event_init(tru_adxl345_event_cap_t *cap, tru_adxl345_dev_t *dev, uint32_t tick_hz, uint32_t odr_mhz, uint8_t pre, uint32_t post, uint8_t trigger_mask){
+	if(odr_mhz == 0) odr_mhz = 1;
+	if(pre == 0) pre = 1;
+	if(pre > TRU_ADXL345_FIFO_DEPTH - 1U) pre = TRU_ADXL345_FIFO_DEPTH - 1U;
+	if(pre + post > TRU_ADXL345_EVENT_MAX) post = TRU_ADXL345_EVENT_MAX - pre;
+
+	cap->dev = dev;
+	cap->state = TRU_ADXL345_EVENT_STATE_ARMED;
+	cap->pre = pre;
+	cap->total = pre + post;
+	cap->trigger_mask = trigger_mask;
+	cap->period_ticks = (uint32_t)((uint64_t)tick_hz * 1000U / odr_mhz);
+	cap->events = 0;
+	cap->truncated = 0;
+	cap->event.seq = 0;
+	cap->event.n = 0;
+}
+
+// Starts waiting for the next trigger.  Any entries still in the FIFO are discarded
+void tru_adxl345_event_arm(tru_adxl345_event_cap_t *cap){
+	tru_adxl345_config_t *shadow = tru_adxl345_shadow(cap->dev);
+
+	// The watermark would stay asserted while the FIFO holds the history
+	shadow->int_enable.bits.watermark = 0;
+	tru_adxl345_shadow_flush(cap->dev);
+
+	// Bypass mode clears the FIFO and resets the trigger
+	shadow->fifo_ctl.bits.fifomode = TRU_ADXL345_FIFOMODE_BYPASS;
+	tru_adxl345_shadow_flush(cap->dev);
+
+	// Keep the newest 32 samples until a trigger, then the last pre of them
+	// and new ones until the FIFO is full.  Only one trigger is recognised
+	// per arming
+	shadow->fifo_ctl.bits.fifomode = TRU_ADXL345_FIFOMODE_TRIGGER;
+	shadow->fifo_ctl.bits.trigger = 0;  // Trigger on INT1
+	shadow->fifo_ctl.bits.samples = cap->pre;
+	tru_adxl345_shadow_flush(cap->dev);
+
+	cap->state = TRU_ADXL345_EVENT_STATE_ARMED;
+}
+
+// Drains the FIFO into the record, up to its size.  ticks is when FIFO_STATUS
+// was read, the newest entry is taken to be from then
+static void tru_adxl345_event_drain(tru_adxl345_event_cap_t *cap, uint32_t entries, uint64_t ticks){
+	tru_adxl345_event_t *event = &cap->event;
+	uint32_t n = entries;
+
+	if(n > TRU_ADXL345_FIFO_DEPTH) n = TRU_ADXL345_FIFO_DEPTH;
+	if(n > cap->total - event->n) n = cap->total - event->n;
+	if(n == 0) return;
+
+	if(event->n == 0) event->first_ticks = ticks - (uint64_t)(entries - 1U) * cap->period_ticks;
+	tru_adxl345_fifo_drain(cap->dev, &event->sample[event->n * ENTRY_SIZE], n);
+	event->n += n;
+}
+
+/*
+	Call from the INT1 interrupt, ticks is the timer count on entry.  The
+	INT_SOURCE value read is returned in int_source, e.g. for tap reporting.
+	Returns the completed event, valid until the next call, or 0.  The
+	capture is re-armed before returning an event.
+*/
+tru_adxl345_event_t *tru_adxl345_event_irq(tru_adxl345_event_cap_t *cap, uint64_t ticks, tru_adxl345_int_source_t *int_source){
+	tru_adxl345_event_t *event = &cap->event;
+	tru_adxl345_fifo_status_t fifo_status;
+	uint64_t status_ticks;
+
+	// Read interrupt triggers, this also clears the tap and activity sources
+	tru_adxl345_i2c_read(cap->dev, int_source, 1, TRU_ADXL345_INT_SOURCE_ADDR);
+
+	if(cap->state == TRU_ADXL345_EVENT_STATE_ARMED){
+		if((int_source->val & cap->trigger_mask) == 0) return 0;
+
+		// The two register reads also cover the 5 us the FIFO needs to settle
+		// after a trigger
+		tru_adxl345_i2c_read(cap->dev, &fifo_status, 1, TRU_ADXL345_FIFO_STATUS_ADDR);
+		status_ticks = gtim_get_counter();
+		if(!fifo_status.bits.fifotrig) return 0;
+
+		event->seq++;
+		event->trigger_ticks = ticks;
+		event->period_ticks = cap->period_ticks;
+		event->int_source = *int_source;
+		event->n = 0;
+
+		// Entries from before the trigger, fewer if the FIFO had not filled that far since arming
+		event->pre = cap->pre;
+		if(fifo_status.bits.entries < cap->pre) event->pre = fifo_status.bits.entries;
+		if(event->pre < cap->pre) cap->truncated++;
+
+		tru_adxl345_event_drain(cap, fifo_status.bits.entries, status_ticks);
+
+		// Collect the rest on the watermark, draining before the FIFO fills up
+		// as FIFO mode would drop samples
+		tru_adxl345_shadow(cap->dev)->int_enable.bits.watermark = 1;
+		tru_adxl345_shadow_flush(cap->dev);
+		cap->state = TRU_ADXL345_EVENT_STATE_CAPTURING;
+	}else{
+		tru_adxl345_i2c_read(cap->dev, &fifo_status, 1, TRU_ADXL345_FIFO_STATUS_ADDR);
+		status_ticks = gtim_get_counter();
+		tru_adxl345_event_drain(cap, fifo_status.bits.entries, status_ticks);
+	}
+
+	if(event->n < cap->total) return 0;
+
+	cap->events++;
+	tru_adxl345_event_arm(cap);
+
+	return event;
+}
+
+// Time of sample i of an event
+uint64_t tru_adxl345_event_sample_ticks(const tru_adxl345_event_t *event, uint32_t i){
+	return event->first_ticks + (uint64_t)i * event->period_ticks;
+}
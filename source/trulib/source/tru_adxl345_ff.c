@@ -0,0 +1,104 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250207
+
+	ADXL345 free-fall detection: the THRESH_FF and TIME_FF settings in
+	physical units, event timestamps and the latency from the start of the
+	fall to the notification.
+*/
+
+#include "tru_adxl345_ff.h"
+
+// Converts a threshold in mg to THRESH_FF, rounded and kept to 1..255
+uint8_t tru_adxl345_ff_thresh(uint32_t mg){
+	uint32_t thr = (mg * 1000U + TRU_ADXL345_FF_THRESH_UG_LSB / 2U) / TRU_ADXL345_FF_THRESH_UG_LSB;
+
+	if(thr < 1U) thr = 1U;
+	if(thr > 255U) thr = 255U;
+	return (uint8_t)thr;
+}
+
+// Converts a time in ms to TIME_FF, rounded and kept to 1..255
+uint8_t tru_adxl345_ff_time(uint32_t ms){
+	uint32_t time = (ms + TRU_ADXL345_FF_TIME_MS_LSB / 2U) / TRU_ADXL345_FF_TIME_MS_LSB;
+
+	if(time < 1U) time = 1U;
+	if(time > 255U) time = 255U;
+	return (uint8_t)time;
+}
+
+// Sets the free-fall threshold and time of a configuration and enables its
+// interrupt.  The caller maps it, e.g. to INT1.  The datasheet suggests 300 to
+// 600 mg and 100 to 350 ms at an output data rate of 100Hz or more
+void tru_adxl345_ff_config(tru_adxl345_config_t *cfg, uint32_t mg, uint32_t ms){
+	cfg->thresh_ff = tru_adxl345_ff_thresh(mg);
+	cfg->time_ff = tru_adxl345_ff_time(ms);
+	cfg->int_enable.bits.freefall = 1;
+}
+
+// time_ff is the TIME_FF register value in use, odr_mhz the output data rate
+void tru_adxl345_ff_init(tru_adxl345_ff_t *ff, uint32_t tick_hz, uint32_t odr_mhz, uint8_t time_ff){
+	ff->tick_hz = tick_hz;
+	ff->fall_ticks = (uint32_t)((uint64_t)tick_hz * time_ff * TRU_ADXL345_FF_TIME_MS_LSB / 1000U);
+	ff->period_ticks = (uint32_t)((uint64_t)tick_hz * 1000U / odr_mhz);
+	ff->events = 0;
+	ff->irq_ticks = 0;
+	ff->onset_ticks = 0;
+	ff->notify_min = UINT32_MAX;
+	ff->notify_max = 0;
+	ff->notify_sum = 0;
+}
+
+/*
+	Records a free-fall seen by the INT1 handler.  irq_ticks is the timer
+	count on entry, notify_ticks when INT_SOURCE showed the free-fall.
+	Returns the estimated start of the fall in ticks.
+*/
+uint64_t tru_adxl345_ff_event(tru_adxl345_ff_t *ff, uint64_t irq_ticks, uint64_t notify_ticks){
+	uint32_t notify = (uint32_t)(notify_ticks - irq_ticks);
+
+	ff->events++;
+	ff->irq_ticks = irq_ticks;
+	ff->onset_ticks = irq_ticks - ff->fall_ticks;  // FREE_FALL is raised TIME_FF after the start, plus up to a sample period
+	if(notify < ff->notify_min) ff->notify_min = notify;
+	if(notify > ff->notify_max) ff->notify_max = notify;
+	ff->notify_sum += notify;
+
+	return ff->onset_ticks;
+}
+
+void tru_adxl345_ff_get_stats(const tru_adxl345_ff_t *ff, tru_adxl345_ff_stats_t *stats){
+	uint32_t ticks_per_us = ff->tick_hz / 1000000U;
+
+	if(ticks_per_us == 0) ticks_per_us = 1;
+	stats->events = ff->events;
+	stats->fall_us = ff->fall_ticks / ticks_per_us;
+	stats->detect_max_us = ff->period_ticks / ticks_per_us;
+	stats->notify_min_us = ff->events ? ff->notify_min / ticks_per_us : 0;
+	stats->notify_max_us = ff->notify_max / ticks_per_us;
+	stats->notify_mean_us = ff->events ? (uint32_t)(ff->notify_sum / ff->events / ticks_per_us) : 0;
+	// Only the entry to notification part is measured, the rest is bounded by
+	// the settings
+	stats->onset_max_us = stats->fall_us + stats->detect_max_us + stats->notify_max_us;
+}
@@ -21,7 +21,7 @@
 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 	SOFTWARE.
 
-	Version: 20241222
+	Version: 20250130
 */
 
 #include "tru_adxl345_ll.h"
@@ -29,90 +29,228 @@
 #include "tru_c5soc_hps_ll.h"
 #include "tru_c5soc_hps_i2c_ll.h"
 
-// Setup HPS I2C0 controller
-void tru_adxl345_i2c_init(uint32_t l4_sp_clk_freq_hz, uint32_t i2c_dev_speed_khz, uint8_t mode10bit, uint16_t dev_addr){
-	// Release I2C0 from reset
-	TRU_HPS_RSTMGR_PERMODRST_REG->bits.i2c0 = 0;
+// Per controller state shared by the devices on it
+typedef struct{
+	uint16_t tar;                   // Target address programmed in IC_TAR, 0 = not set
+	tru_adxl345_i2c_stats_t stats;
+}tru_adxl345_bus_t;
 
-	// Temporary disable I2C0
-	TRU_HPS_I2C0_IC_ENABLE_REG->bits.enable = 0;
+static tru_adxl345_bus_t tru_adxl345_bus[TRU_ADXL345_I2C_BUSES];
+
+// The controllers are 4KB apart, starting at I2C0
+static inline tru_adxl345_bus_t *tru_adxl345_get_bus(uint32_t i2c_base){
+	return &tru_adxl345_bus[((i2c_base - TRU_HPS_I2C0_BASE) >> 12) & (TRU_ADXL345_I2C_BUSES - 1)];
+}
+
+// Fills in a device handle.  It does not touch the hardware, call
+// tru_adxl345_i2c_init() once per controller and tru_adxl345_shadow_load()
+// once per device
+void tru_adxl345_dev_init(tru_adxl345_dev_t *dev, uint32_t i2c_base, uint16_t addr){
+	dev->i2c_base = i2c_base;
+	dev->addr = addr;
+	dev->shadow_stats.hits = 0;
+	dev->shadow_stats.flushes = 0;
+}
+
+// Converts a time in nanoseconds to the number of clock cycles, rounding up
+static inline uint32_t tru_adxl345_ns_to_cycles(uint32_t ns, uint32_t clk_freq_hz){
+	return (uint32_t)DIV_CEIL((uint64_t)ns * clk_freq_hz, 1000000000ULL);
+}
+
+// Calculates the spike filter length and the SCL low and high counts.  This
+// does not touch any hardware so it can be checked on a host PC.
+//
+// Equations under Figure 21-12: Impact of SCL Rise Time and Fall Time on
+// Generated SCL (Cyclone V HPS TRM):
+//   SCL_HIGH_TIME = (HCNT + IC_FS_SPKLEN + 7) * (1/ic_clk) + SCL_FALL_TIME
+//   SCL_LOW_TIME  = (LCNT + 1) * (1/ic_clk) - SCL_FALL_TIME + SCL_RISE_TIME
+// *Where ic_clk = l4_sp_clk_freq
+//
+// Rearranged, with the time to cycles conversion done in 64-bit fixed point:
+//   HCNT = CEIL((SCL_HIGH_TIME - SCL_FALL_TIME) * ic_clk) - IC_FS_SPKLEN - 7
+//   LCNT = CEIL((SCL_LOW_TIME + SCL_FALL_TIME - SCL_RISE_TIME) * ic_clk) - 1
+//
+// The high and low times are only the minimums, so any cycles left over
+// within the requested SCL period (which also includes the rise time) are
+// shared between the two phases in the same ratio as the minimum times.
+void tru_adxl345_i2c_scl_calc(uint32_t l4_sp_clk_freq_hz, uint32_t i2c_dev_speed_hz, tru_adxl345_i2c_scl_t *scl){
+	uint32_t high_ns, low_ns, rise_ns, fall_ns;
+	uint32_t high_cyc, low_cyc, period_ns, period_cyc, extra_cyc;
+
+	if(i2c_dev_speed_hz > 100000){
+		scl->speed = TRU_HPS_I2C_CON_SPEED_400K;
+		high_ns = TRU_ADXL345_I2C_SCL_HIGH_TIME_NS;
+		low_ns = TRU_ADXL345_I2C_SCL_LOW_TIME_NS;
+		rise_ns = TRU_ADXL345_I2C_RISE_TIME_NS;
+		fall_ns = TRU_ADXL345_I2C_FALL_TIME_NS;
+	}else{
+		scl->speed = TRU_HPS_I2C_CON_SPEED_100K;
+		high_ns = TRU_ADXL345_I2C_SS_SCL_HIGH_TIME_NS;
+		low_ns = TRU_ADXL345_I2C_SS_SCL_LOW_TIME_NS;
+		rise_ns = TRU_ADXL345_I2C_SS_RISE_TIME_NS;
+		fall_ns = TRU_ADXL345_I2C_SS_FALL_TIME_NS;
+	}
+	if(i2c_dev_speed_hz == 0) i2c_dev_speed_hz = 100000;
+
+	// The spike filter length is derived from the clock, minimum is 1
+	scl->spklen = tru_adxl345_ns_to_cycles(TRU_ADXL345_I2C_SPIKE_TIME_NS, l4_sp_clk_freq_hz);
+	if(scl->spklen == 0) scl->spklen = 1;
+	if(scl->spklen > 0xff) scl->spklen = 0xff;
+
+	// Minimum cycles for each phase
+	high_cyc = (high_ns > fall_ns) ? tru_adxl345_ns_to_cycles(high_ns - fall_ns, l4_sp_clk_freq_hz) : 0;
+	low_cyc = tru_adxl345_ns_to_cycles(low_ns + fall_ns - rise_ns, l4_sp_clk_freq_hz);
+
+	// Stretch to the requested SCL period
+	period_ns = DIV_CEIL(1000000000U, i2c_dev_speed_hz);
+	period_cyc = (period_ns > rise_ns) ? tru_adxl345_ns_to_cycles(period_ns - rise_ns, l4_sp_clk_freq_hz) : 0;
+	if(period_cyc > high_cyc + low_cyc){
+		extra_cyc = period_cyc - high_cyc - low_cyc;
+		low_cyc += (uint32_t)(((uint64_t)extra_cyc * low_ns) / (low_ns + high_ns));
+		high_cyc = period_cyc - low_cyc;
+	}
+
+	// Apply the controller limits: HCNT > IC_FS_SPKLEN + 5 and LCNT > IC_FS_SPKLEN + 7
+	scl->hcnt = (high_cyc > scl->spklen + 7) ? high_cyc - scl->spklen - 7 : 0;
+	scl->lcnt = (low_cyc > 1) ? low_cyc - 1 : 0;
+	if(scl->hcnt < scl->spklen + 6) scl->hcnt = scl->spklen + 6;
+	if(scl->lcnt < scl->spklen + 8) scl->lcnt = scl->spklen + 8;
+	if(scl->hcnt > 0xffff) scl->hcnt = 0xffff;
+	if(scl->lcnt > 0xffff) scl->lcnt = 0xffff;
+}
+
+// Returns the effective SCL frequency in Hz for the given timing, using the
+// same equations as above
+uint32_t tru_adxl345_i2c_scl_freq(uint32_t l4_sp_clk_freq_hz, const tru_adxl345_i2c_scl_t *scl){
+	uint32_t rise_ns = (scl->speed == TRU_HPS_I2C_CON_SPEED_400K) ? TRU_ADXL345_I2C_RISE_TIME_NS : TRU_ADXL345_I2C_SS_RISE_TIME_NS;
+	uint64_t cycles = (uint64_t)scl->hcnt + scl->spklen + 7 + scl->lcnt + 1;
+	uint64_t period_ps;
+
+	if(l4_sp_clk_freq_hz == 0) return 0;
+
+	// Use picoseconds to keep the rounding error small
+	period_ps = (cycles * 1000000000000ULL) / l4_sp_clk_freq_hz + (uint64_t)rise_ns * 1000;
+	return (uint32_t)((1000000000000ULL + period_ps / 2) / period_ps);
+}
+
+// Self-check: reads back the programmed timing from the device's controller
+// and returns the effective SCL frequency in Hz
+uint32_t tru_adxl345_i2c_scl_readback(tru_adxl345_dev_t *dev, uint32_t l4_sp_clk_freq_hz, tru_adxl345_i2c_scl_t *scl){
+	uint32_t base = dev->i2c_base;
+
+	scl->speed = TRU_HPS_I2C_IC_CON_REG(base)->bits.speed;
+	scl->spklen = TRU_HPS_I2C_IC_FS_SPKLEN_REG(base)->bits.spklen;
+	if(scl->speed == TRU_HPS_I2C_CON_SPEED_400K){
+		scl->hcnt = TRU_HPS_I2C_IC_FS_SCL_HCNT_REG(base)->bits.ic_fs_scl_hcnt;
+		scl->lcnt = TRU_HPS_I2C_IC_FS_SCL_LCNT_REG(base)->bits.ic_fs_scl_lcnt;
+	}else{
+		scl->hcnt = TRU_HPS_I2C_IC_SS_SCL_HCNT_REG(base)->bits.ic_ss_scl_hcnt;
+		scl->lcnt = TRU_HPS_I2C_IC_SS_SCL_LCNT_REG(base)->bits.ic_ss_scl_lcnt;
+	}
+
+	return tru_adxl345_i2c_scl_freq(l4_sp_clk_freq_hz, scl);
+}
+
+// Setup the HPS I2C controller of the device and point it at the device.
+// Other devices on the same controller only need tru_adxl345_dev_init()
+// Note, IC_CON, IC_TAR, the SCL counts and IC_FS_SPKLEN can only be written
+// while the controller is disabled, so they are all set before enabling
+void tru_adxl345_i2c_init(tru_adxl345_dev_t *dev, uint32_t l4_sp_clk_freq_hz, uint32_t i2c_dev_speed_khz){
+	uint32_t base = dev->i2c_base;
+	tru_adxl345_i2c_scl_t scl;
+
+	// Release the controller from reset
+	switch(base){
+		case TRU_HPS_I2C0_BASE: TRU_HPS_RSTMGR_PERMODRST_REG->bits.i2c0 = 0; break;
+		case TRU_HPS_I2C1_BASE: TRU_HPS_RSTMGR_PERMODRST_REG->bits.i2c1 = 0; break;
+		case TRU_HPS_I2C2_BASE: TRU_HPS_RSTMGR_PERMODRST_REG->bits.i2c2 = 0; break;
+		case TRU_HPS_I2C3_BASE: TRU_HPS_RSTMGR_PERMODRST_REG->bits.i2c3 = 0; break;
+	}
+
+	// Temporary disable the controller
+	TRU_HPS_I2C_IC_ENABLE_REG(base)->bits.enable = 0;
+
+	// Calculate the SCL timing for the desired speed
+	tru_adxl345_i2c_scl_calc(l4_sp_clk_freq_hz, i2c_dev_speed_khz, &scl);
 
 	// Setup defaults
-	tru_hps_i2c_ic_con_var_t con = { .val = TRU_HPS_I2C0_IC_CON_REG->val };
+	tru_hps_i2c_ic_con_var_t con = { .val = TRU_HPS_I2C_IC_CON_REG(base)->val };
 	con.bits.master_mode = TRU_HPS_I2C_CON_MASTER_ENABLE;
-	con.bits.speed = TRU_HPS_I2C_CON_SPEED_100K;
+	con.bits.speed = scl.speed;
 	con.bits.ic_10bitaddr_slave = TRU_HPS_I2C_CON_ADDR_7BIT;
 	con.bits.ic_10bitaddr_master = TRU_HPS_I2C_CON_ADDR_7BIT;
 	con.bits.ic_restart_en = TRU_HPS_I2C_CON_RESTART_ENABLE;
 	con.bits.ic_slave_disable = TRU_HPS_I2C_CON_SLAVE_DISABLE;
-	TRU_HPS_I2C0_IC_CON_REG->val = con.val;
+	TRU_HPS_I2C_IC_CON_REG(base)->val = con.val;
 
-	// Unmask and clear interrupt triggers
-	TRU_HPS_I2C0_IC_INTR_MASK_REG->val = TRU_HPS_I2C_INTR_MASK_ENABLE_ALL;
-	TRU_HPS_I2C0_IC_CLR_INTR_REG->val = TRU_HPS_I2C_CLR_INTR_ALL;
-
-	// Enable DMA controller support
-	//TRU_HPS_I2C0_IC_DMA_CR_REG->bits.rdmae = 1;
-	//TRU_HPS_I2C0_IC_DMA_CR_REG->bits.tdmae = 1;
-
-	// Enable I2C0
-	TRU_HPS_I2C0_IC_ENABLE_REG->bits.enable = 1;
-
-	// Set desired speed and filter duration
-	// The low pass filter (spike filter) duration is set using number of cycles of the l4_sp_clk (default = 100MHz, so 10ns cycle)
-	// TODO: Filter duration must be less than the SCL high and low time so perhaps best we calculate and use some fraction of that time,
-	// anyway let's go with these fixed values for now
-	if(i2c_dev_speed_khz > 100000){
-		con.bits.speed = TRU_HPS_I2C_CON_SPEED_400K;
-		TRU_HPS_I2C0_IC_FS_SPKLEN_REG->bits.spklen = 2;  // 20ns (at 100MHz)
+	// Set the spike filter duration and the low and high counts
+	TRU_HPS_I2C_IC_FS_SPKLEN_REG(base)->bits.spklen = scl.spklen;
+	if(scl.speed == TRU_HPS_I2C_CON_SPEED_400K){
+		TRU_HPS_I2C_IC_FS_SCL_LCNT_REG(base)->bits.ic_fs_scl_lcnt = scl.lcnt;
+		TRU_HPS_I2C_IC_FS_SCL_HCNT_REG(base)->bits.ic_fs_scl_hcnt = scl.hcnt;
 	}else{
-		con.bits.speed = TRU_HPS_I2C_CON_SPEED_100K;
-		TRU_HPS_I2C0_IC_FS_SPKLEN_REG->bits.spklen = 8;  // 80ns (at 100MHz)
+		TRU_HPS_I2C_IC_SS_SCL_LCNT_REG(base)->bits.ic_ss_scl_lcnt = scl.lcnt;
+		TRU_HPS_I2C_IC_SS_SCL_HCNT_REG(base)->bits.ic_ss_scl_hcnt = scl.hcnt;
 	}
 
-	// Set low and high count using calculations taken from HWLIB
-/*
-	uint32_t scl_cnt = l4_sp_clk_freq_hz / (2 * i2c_dev_speed_khz);
-	TRU_HPS_I2C0_IC_SS_SCL_LCNT_REG->bits.ic_ss_scl_lcnt = scl_cnt - 1;
-	TRU_HPS_I2C0_IC_FS_SCL_LCNT_REG->bits.ic_fs_scl_lcnt = TRU_HPS_I2C0_IC_SS_SCL_LCNT_REG->bits.ic_ss_scl_lcnt;
-	TRU_HPS_I2C0_IC_SS_SCL_HCNT_REG->bits.ic_ss_scl_hcnt = scl_cnt - TRU_HPS_I2C0_IC_FS_SPKLEN_REG->bits.spklen - 6;
-	TRU_HPS_I2C0_IC_FS_SCL_HCNT_REG->bits.ic_fs_scl_hcnt = TRU_HPS_I2C0_IC_SS_SCL_HCNT_REG->bits.ic_ss_scl_hcnt;
-*/
+	// Set device address
+	TRU_HPS_I2C_IC_TAR_REG(base)->bits.ic_10bitaddr_master = TRU_HPS_I2C_CON_ADDR_7BIT;
+	TRU_HPS_I2C_IC_TAR_REG(base)->bits.ic_tar = dev->addr;
+	tru_adxl345_get_bus(base)->tar = dev->addr;
 
-	// Set low and high count using correct calculations from my understanding
-	// Corrected equations under Figure 21-12: Impact of SCL Rise Time and Fall Time on Generated SCL:
-	// SCL_LOW_TIME = (LCNT + 1) * (1/ic_clk) + SCL_FALL_TIME + SCL_RISE_TIME
-	// SCL_HIGH_TIME = (HCNT + IC_FS_SPKLEN + 6) * (1/ic_clk) + SCL_FALL_TIME
-	// *Where ic_clk = l4_sp_clk_freq, and with equivalent units
-	// The equations in the datasheet should multiply by the cycle (i.e. period), hence 1/ic_clk
-	// Rearranging the above equations, adding in equivalent units and rounding up gives us:
-	// LCNT = CEIL(SCL_LOW_TIME_NS * (l4_sp_clk_freq_hz / 1000000000)) - 1 - SCL_FALL_TIME_NS + SCL_RISE_TIME_NS
-	// HCNT = CEIL(SCL_HIGH_TIME_NS * (l4_sp_clk_freq_hz / 1000000000)) - IC_FS_SPKLEN - 6 - SCL_FALL_TIME_NS
-	TRU_HPS_I2C0_IC_SS_SCL_LCNT_REG->bits.ic_ss_scl_lcnt = TRU_ADXL345_I2C_SCL_LOW_TIME_NS * DIV_CEIL(l4_sp_clk_freq_hz, 1000000000) - 1;
-	TRU_HPS_I2C0_IC_FS_SCL_LCNT_REG->bits.ic_fs_scl_lcnt = TRU_HPS_I2C0_IC_SS_SCL_LCNT_REG->bits.ic_ss_scl_lcnt;
-	TRU_HPS_I2C0_IC_SS_SCL_HCNT_REG->bits.ic_ss_scl_hcnt = TRU_ADXL345_I2C_SCL_HIGH_TIME_NS * DIV_CEIL(l4_sp_clk_freq_hz, 1000000000) - TRU_HPS_I2C0_IC_FS_SPKLEN_REG->bits.spklen - 6 - TRU_ADXL345_I2C_FALL_TIME_NS;
-	TRU_HPS_I2C0_IC_FS_SCL_HCNT_REG->bits.ic_fs_scl_hcnt = TRU_HPS_I2C0_IC_SS_SCL_HCNT_REG->bits.ic_ss_scl_hcnt;
+	// Unmask and clear interrupt triggers
+	TRU_HPS_I2C_IC_INTR_MASK_REG(base)->val = TRU_HPS_I2C_INTR_MASK_ENABLE_ALL;
+	TRU_HPS_I2C_IC_CLR_INTR_REG(base)->val = TRU_HPS_I2C_CLR_INTR_ALL;
 
-	// Set device address
-	TRU_HPS_I2C0_IC_TAR_REG->bits.ic_10bitaddr_master = mode10bit;
-	TRU_HPS_I2C0_IC_TAR_REG->bits.ic_tar = dev_addr;
+	// DMA handshaking is off, it is only enabled while a DMA drain runs (see tru_adxl345_dma.c)
+	TRU_HPS_I2C_IC_DMA_CR_REG(base)->val = 0;
+
+	// Enable the controller
+	TRU_HPS_I2C_IC_ENABLE_REG(base)->bits.enable = 1;
+}
+
+// Points the controller at the device.  IC_TAR can only be written while the
+// controller is disabled, and disabling it while a transfer is running aborts
+// the transfer, so a switch first waits for the queued commands to finish.
+// Accesses to the device already selected cost nothing, so a scheduler that
+// does all the work for one device before moving on keeps the switches down.
+// The blocking functions call this, the non-blocking and DMA engines address
+// whichever device was selected last
+void tru_adxl345_i2c_select(tru_adxl345_dev_t *dev){
+	uint32_t base = dev->i2c_base;
+	tru_adxl345_bus_t *bus = tru_adxl345_get_bus(base);
+
+	if(bus->tar == dev->addr) return;
+
+	while(TRU_HPS_I2C_IC_STATUS_REG(base)->bits.tfe == 0 || TRU_HPS_I2C_IC_STATUS_REG(base)->bits.mst_activity);
+	TRU_HPS_I2C_IC_ENABLE_REG(base)->bits.enable = 0;
+	while(TRU_HPS_I2C_IC_ENABLE_STATUS_REG(base)->bits.ic_en);
+	TRU_HPS_I2C_IC_TAR_REG(base)->bits.ic_tar = dev->addr;
+	TRU_HPS_I2C_IC_ENABLE_REG(base)->bits.enable = 1;
+
+	bus->tar = dev->addr;
+	bus->stats.tar_switches++;
 }
 
 // Reads using burst mode (multiple I2C reads), making better use of the FIFO
-// Read data using HPS I2C0 controller
-void tru_adxl345_i2c_read_bm(void *buf, uint32_t len, uint32_t reg_addr_start){
+// Read data using the device's HPS I2C controller
+void tru_adxl345_i2c_read_bm(tru_adxl345_dev_t *dev, void *buf, uint32_t len, uint32_t reg_addr_start){
+	uint32_t base = dev->i2c_base;
 	uint8_t *buf8 = buf;
 	tru_hps_i2c_ic_data_cmd_var_t data_cmd = { .val = 0 };
 	uint8_t txremain;
 	uint8_t rxremain;
 
+	tru_adxl345_i2c_select(dev);
+	tru_adxl345_i2c_count(base, 0, 1, len);
+
 	// Send write command and register address
-	while(TRU_HPS_I2C0_IC_STATUS_REG->bits.tfnf == 0);  // Ensure TXFIFO is not full
+	while(TRU_HPS_I2C_IC_STATUS_REG(base)->bits.tfnf == 0);  // Ensure TXFIFO is not full
 	data_cmd.bits.cmd = TRU_HPS_I2C_DATA_CMD_MASTER_WRITE;
 	data_cmd.bits.dat = reg_addr_start;
 	data_cmd.bits.restart = TRU_HPS_I2C_DATA_CMD_ISSUE_RESTART_YES;
 	data_cmd.bits.stop = TRU_HPS_I2C_DATA_CMD_ISSUE_STOP_NO;
-	TRU_HPS_I2C0_IC_DATA_CMD_REG->val = data_cmd.val;
+	TRU_HPS_I2C_IC_DATA_CMD_REG(base)->val = data_cmd.val;
 
 	// Set common read values
 	data_cmd.bits.cmd = TRU_HPS_I2C_DATA_CMD_MASTER_READ;
@@ -131,35 +269,93 @@ void tru_adxl345_i2c_read_bm(void *buf, uint32_t len, uint32_t reg_addr_start){
 
 		// Send read commands to fill up the RXFIFO
 		while(txremain){
-			while(TRU_HPS_I2C0_IC_STATUS_REG->bits.tfnf == 0);  // Ensure TXFIFO is not full
+			while(TRU_HPS_I2C_IC_STATUS_REG(base)->bits.tfnf == 0);  // Ensure TXFIFO is not full
 			len--;
 			if(len == 0) data_cmd.bits.stop = TRU_HPS_I2C_DATA_CMD_ISSUE_STOP_YES;
-			TRU_HPS_I2C0_IC_DATA_CMD_REG->val = data_cmd.val;
+			TRU_HPS_I2C_IC_DATA_CMD_REG(base)->val = data_cmd.val;
 			txremain--;
 		}
 
 		// Now we read the received data from the RXFIFO
 		while(rxremain){
-			while(TRU_HPS_I2C0_IC_STATUS_REG->bits.rfne == 0);  // Wait till we have data
-			buf8[0] = TRU_HPS_I2C0_IC_DATA_CMD_REG->bits.dat;  // Store the received data
+			while(TRU_HPS_I2C_IC_STATUS_REG(base)->bits.rfne == 0);  // Wait till we have data
+			buf8[0] = TRU_HPS_I2C_IC_DATA_CMD_REG(base)->bits.dat;  // Store the received data
 			buf8++;
 			rxremain--;
 		}
 	}
 }
 
-// Read data using HPS I2C0 controller
-void tru_adxl345_i2c_read(void *buf, uint32_t len, uint32_t reg_addr_start){
+// Reads n ADXL345 FIFO entries (6 bytes each, DATAX0 to DATAZ1) into buf
+// Each entry needs its own I2C transaction, so instead of waiting for one
+// transaction to finish before starting the next, the commands for the
+// following entries are queued while data is still arriving.  This keeps the
+// TXFIFO topped up so the transactions run back-to-back without idle bus time.
+// The number of read commands in flight is limited to the RXFIFO depth so
+// the RXFIFO can't overflow
+void tru_adxl345_fifo_drain(tru_adxl345_dev_t *dev, void *buf, uint32_t n){
+	uint32_t base = dev->i2c_base;
 	uint8_t *buf8 = buf;
 	tru_hps_i2c_ic_data_cmd_var_t data_cmd = { .val = 0 };
+	uint32_t rxremain = n * 6;  // Bytes still to receive
+	uint32_t txentry = 0;       // Entry having its commands queued
+	uint32_t txcmd = 0;         // Next command of that entry, 0 = address, 1 to 6 = reads
+	uint32_t inflight = 0;      // Read commands queued but not yet received
+
+	tru_adxl345_i2c_select(dev);
+	tru_adxl345_i2c_count(base, 0, n, n * 6);
+	while(rxremain){
+		// Queue as many commands as possible
+		while(txentry < n && TRU_HPS_I2C_IC_STATUS_REG(base)->bits.tfnf){
+			if(txcmd == 0){
+				// Write command and register address
+				data_cmd.bits.cmd = TRU_HPS_I2C_DATA_CMD_MASTER_WRITE;
+				data_cmd.bits.dat = TRU_ADXL345_DATAX0_ADDR;
+				data_cmd.bits.restart = TRU_HPS_I2C_DATA_CMD_ISSUE_RESTART_YES;
+				data_cmd.bits.stop = TRU_HPS_I2C_DATA_CMD_ISSUE_STOP_NO;
+			}else{
+				if(inflight >= TRU_HPS_I2C_RXFIFO_DEPTH) break;
+				data_cmd.bits.cmd = TRU_HPS_I2C_DATA_CMD_MASTER_READ;
+				data_cmd.bits.dat = 0;
+				data_cmd.bits.restart = TRU_HPS_I2C_DATA_CMD_ISSUE_RESTART_NO;
+				data_cmd.bits.stop = (txcmd == 6) ? TRU_HPS_I2C_DATA_CMD_ISSUE_STOP_YES : TRU_HPS_I2C_DATA_CMD_ISSUE_STOP_NO;
+				inflight++;
+			}
+			TRU_HPS_I2C_IC_DATA_CMD_REG(base)->val = data_cmd.val;
+
+			txcmd++;
+			if(txcmd > 6){
+				txcmd = 0;
+				txentry++;
+			}
+		}
+
+		// Read out what has arrived
+		while(TRU_HPS_I2C_IC_STATUS_REG(base)->bits.rfne){
+			buf8[0] = TRU_HPS_I2C_IC_DATA_CMD_REG(base)->bits.dat;
+			buf8++;
+			inflight--;
+			rxremain--;
+		}
+	}
+}
+
+// Read data using the device's HPS I2C controller
+void tru_adxl345_i2c_read(tru_adxl345_dev_t *dev, void *buf, uint32_t len, uint32_t reg_addr_start){
+	uint32_t base = dev->i2c_base;
+	uint8_t *buf8 = buf;
+	tru_hps_i2c_ic_data_cmd_var_t data_cmd = { .val = 0 };
+
+	tru_adxl345_i2c_select(dev);
+	tru_adxl345_i2c_count(base, 0, 1, len);
 
 	// Send write command and register address
-	while(TRU_HPS_I2C0_IC_STATUS_REG->bits.tfnf == 0);  // Ensure TXFIFO is not full
+	while(TRU_HPS_I2C_IC_STATUS_REG(base)->bits.tfnf == 0);  // Ensure TXFIFO is not full
 	data_cmd.bits.cmd = TRU_HPS_I2C_DATA_CMD_MASTER_WRITE;
 	data_cmd.bits.dat = reg_addr_start;
 	data_cmd.bits.restart = TRU_HPS_I2C_DATA_CMD_ISSUE_RESTART_YES;
 	data_cmd.bits.stop = TRU_HPS_I2C_DATA_CMD_ISSUE_STOP_NO;
-	TRU_HPS_I2C0_IC_DATA_CMD_REG->val = data_cmd.val;
+	TRU_HPS_I2C_IC_DATA_CMD_REG(base)->val = data_cmd.val;
 
 	// Set common read values
 	data_cmd.bits.cmd = TRU_HPS_I2C_DATA_CMD_MASTER_READ;
@@ -168,50 +364,72 @@ void tru_adxl345_i2c_read(void *buf, uint32_t len, uint32_t reg_addr_start){
 	data_cmd.bits.stop = TRU_HPS_I2C_DATA_CMD_ISSUE_STOP_NO;
 	while(len){
 		// Send read command
-		while(TRU_HPS_I2C0_IC_STATUS_REG->bits.tfnf == 0);  // Ensure TXFIFO is not full
+		while(TRU_HPS_I2C_IC_STATUS_REG(base)->bits.tfnf == 0);  // Ensure TXFIFO is not full
 		len--;
 		if(len == 0) data_cmd.bits.stop = TRU_HPS_I2C_DATA_CMD_ISSUE_STOP_YES;
-		TRU_HPS_I2C0_IC_DATA_CMD_REG->val = data_cmd.val;
+		TRU_HPS_I2C_IC_DATA_CMD_REG(base)->val = data_cmd.val;
 
 		// Store the received data
-		while(TRU_HPS_I2C0_IC_STATUS_REG->bits.rfne == 0);  // Wait till we have data
-		buf8[0] = TRU_HPS_I2C0_IC_DATA_CMD_REG->bits.dat;
+		while(TRU_HPS_I2C_IC_STATUS_REG(base)->bits.rfne == 0);  // Wait till we have data
+		buf8[0] = TRU_HPS_I2C_IC_DATA_CMD_REG(base)->bits.dat;
 		buf8++;
 	}
 }
 
-// Write data using HPS I2C0 controller
-void tru_adxl345_i2c_write(void *buf, uint32_t len, uint32_t reg_addr_start){
+// Write data using the device's HPS I2C controller
+void tru_adxl345_i2c_write(tru_adxl345_dev_t *dev, void *buf, uint32_t len, uint32_t reg_addr_start){
+	uint32_t base = dev->i2c_base;
 	uint8_t *buf8 = buf;
 	tru_hps_i2c_ic_data_cmd_var_t data_cmd = { .val = 0 };
 
+	tru_adxl345_i2c_select(dev);
+	tru_adxl345_i2c_count(base, 1, 1, len);
+
 	// Send write command and register address
-	while(TRU_HPS_I2C0_IC_STATUS_REG->bits.tfnf == 0);  // Ensure TXFIFO is not full
+	while(TRU_HPS_I2C_IC_STATUS_REG(base)->bits.tfnf == 0);  // Ensure TXFIFO is not full
 	data_cmd.bits.cmd = TRU_HPS_I2C_DATA_CMD_MASTER_WRITE;
 	data_cmd.bits.dat = reg_addr_start;
 	data_cmd.bits.restart = TRU_HPS_I2C_DATA_CMD_ISSUE_RESTART_NO;
 	data_cmd.bits.stop = TRU_HPS_I2C_DATA_CMD_ISSUE_STOP_NO;
-	TRU_HPS_I2C0_IC_DATA_CMD_REG->val = data_cmd.val;
+	TRU_HPS_I2C_IC_DATA_CMD_REG(base)->val = data_cmd.val;
 
 	while(len){
 		// Send data
-		while(TRU_HPS_I2C0_IC_STATUS_REG->bits.tfnf == 0);  // Ensure TXFIFO is not full
+		while(TRU_HPS_I2C_IC_STATUS_REG(base)->bits.tfnf == 0);  // Ensure TXFIFO is not full
 		len--;
 		data_cmd.bits.dat = buf8[0];
 		if(len == 0) data_cmd.bits.stop = TRU_HPS_I2C_DATA_CMD_ISSUE_STOP_YES;
-		TRU_HPS_I2C0_IC_DATA_CMD_REG->val = data_cmd.val;
+		TRU_HPS_I2C_IC_DATA_CMD_REG(base)->val = data_cmd.val;
 		buf8++;
 	}
 }
 
-void tru_adxl345_i2c_stop_flush_fifo(void){
+void tru_adxl345_i2c_stop_flush_fifo(tru_adxl345_dev_t *dev){
 	uint8_t buf[1];
 
 	TRU_ADXL345_POWER_CTL_PTR(buf)->val = 0;
 	TRU_ADXL345_POWER_CTL_PTR(buf)->bits.measure = 0;
-	tru_adxl345_i2c_write(buf, 1, TRU_ADXL345_POWER_CTL_ADDR);
+	tru_adxl345_i2c_write(dev, buf, 1, TRU_ADXL345_POWER_CTL_ADDR);
 
 	TRU_ADXL345_FIFO_CTL_PTR(buf)->val = 0;
 	TRU_ADXL345_FIFO_CTL_PTR(buf)->bits.fifomode = TRU_ADXL345_FIFOMODE_BYPASS;
-	tru_adxl345_i2c_write(buf, 1, TRU_ADXL345_FIFO_CTL_ADDR);
+	tru_adxl345_i2c_write(dev, buf, 1, TRU_ADXL345_FIFO_CTL_ADDR);
+}
+
+// Adds to the bus transaction counters of a controller.  They are plain
+// counters, an update from an interrupt in the middle of another can be lost
+void tru_adxl345_i2c_count(uint32_t i2c_base, uint8_t write, uint32_t transactions, uint32_t bytes){
+	tru_adxl345_i2c_stats_t *stats = &tru_adxl345_get_bus(i2c_base)->stats;
+
+	if(write){
+		stats->writes += transactions;
+		stats->write_bytes += bytes;
+	}else{
+		stats->reads += transactions;
+		stats->read_bytes += bytes;
+	}
+}
+
+void tru_adxl345_i2c_get_stats(uint32_t i2c_base, tru_adxl345_i2c_stats_t *stats){
+	*stats = tru_adxl345_get_bus(i2c_base)->stats;
 }
@@ -0,0 +1,152 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250205
+
+	Wake-on-motion power management for the ADXL345, using the linked
+	activity and inactivity functions with AUTO_SLEEP, and the wake-up
+	latency from the activity interrupt to the first full rate sample.
+*/
+
+#include "tru_adxl345_pm.h"
+#include "tru_adxl345_cfg.h"
+
+static const uint32_t wakeup_hz[4] = { 8, 4, 2, 1 };
+
+/*
+	Sets the activity, inactivity and power control fields of a configuration.
+	thresh_act, thresh_inact : 62.5 mg/LSB, AC coupled on all axes
+	time_inact               : seconds below thresh_inact before sleeping
+	wakeup                   : TRU_ADXL345_WAKEUP_* sampling rate while asleep
+*/
+void tru_adxl345_pm_config(tru_adxl345_config_t *cfg, uint8_t thresh_act, uint8_t thresh_inact, uint8_t time_inact, uint8_t wakeup){
+	cfg->thresh_act = thresh_act;
+	cfg->thresh_inact = thresh_inact;
+	cfg->time_inact = time_inact;
+	cfg->act_inact_ctl.bits.act_acdc = 1;
+	cfg->act_inact_ctl.bits.act_x_en = 1;
+	cfg->act_inact_ctl.bits.act_y_en = 1;
+	cfg->act_inact_ctl.bits.act_z_en = 1;
+	cfg->act_inact_ctl.bits.inact_acdc = 1;
+	cfg->act_inact_ctl.bits.inact_x_en = 1;
+	cfg->act_inact_ctl.bits.inact_y_en = 1;
+	cfg->act_inact_ctl.bits.inact_z_en = 1;
+	// Activity and inactivity are looked for in turn, and the device sleeps by
+	// itself on inactivity, sampling at the wakeup rate until activity
+	cfg->power_ctl.bits.link = 1;
+	cfg->power_ctl.bits.autosleep = 1;
+	cfg->power_ctl.bits.wakeup = wakeup;
+	cfg->int_enable.bits.activity = 1;
+	cfg->int_enable.bits.inactivity = 1;
+}
+
+void tru_adxl345_pm_init(tru_adxl345_pm_t *pm, tru_adxl345_dev_t *dev, uint32_t tick_hz, uint8_t wakeup, uint64_t ticks){
+	pm->dev = dev;
+	pm->tick_hz = tick_hz;
+	pm->wakeup = wakeup & 3U;
+	pm->asleep = 0;
+	pm->int_enable = 0;
+	pm->init_ticks = ticks;
+	pm->sleep_ticks = 0;
+	pm->asleep_ticks = 0;
+	pm->wake_ticks = 0;
+	pm->sleeps = 0;
+	pm->wakes = 0;
+	pm->latency_min = UINT32_MAX;
+	pm->latency_max = 0;
+	pm->latency_sum = 0;
+	pm->latency_count = 0;
+}
+
+/*
+	Call from the INT1 interrupt with the INT_SOURCE value read, after the
+	FIFO has been drained.  ticks is the timer count on entry.
+	Returns TRU_ADXL345_PM_SLEPT, TRU_ADXL345_PM_WOKE or 0.
+*/
+uint8_t tru_adxl345_pm_irq(tru_adxl345_pm_t *pm, uint64_t ticks, tru_adxl345_int_source_t int_source){
+	tru_adxl345_config_t *shadow = tru_adxl345_shadow(pm->dev);
+
+	if(int_source.bits.inactivity && !pm->asleep){
+		// Keep the samples at the wakeup rate from waking the CPU
+		pm->int_enable = shadow->int_enable.val;
+		shadow->int_enable.bits.watermark = 0;
+		shadow->int_enable.bits.dataready = 0;
+		tru_adxl345_shadow_flush(pm->dev);
+
+		pm->asleep = 1;
+		pm->sleep_ticks = ticks;
+		pm->wake_ticks = 0;
+		pm->sleeps++;
+		return TRU_ADXL345_PM_SLEPT;
+	}
+
+	if(int_source.bits.activity && pm->asleep){
+		// Discard the samples taken at the wakeup rate
+		shadow->fifo_ctl.bits.fifomode = TRU_ADXL345_FIFOMODE_BYPASS;
+		tru_adxl345_shadow_flush(pm->dev);
+		shadow->fifo_ctl.bits.fifomode = TRU_ADXL345_FIFOMODE_STREAM;
+		shadow->int_enable.val = pm->int_enable;
+		tru_adxl345_shadow_flush(pm->dev);
+
+		pm->asleep = 0;
+		pm->asleep_ticks += ticks - pm->sleep_ticks;
+		pm->wake_ticks = ticks;
+		pm->wakes++;
+		return TRU_ADXL345_PM_WOKE;
+	}
+
+	return 0;
+}
+
+// Call with the time of the first sample of each drain.  Returns 1 with the
+// wake-up latency in microseconds for the first drain after a wake-up, else 0
+uint8_t tru_adxl345_pm_sample(tru_adxl345_pm_t *pm, uint64_t sample_ticks, uint32_t *latency_us){
+	uint32_t latency;
+
+	if(pm->wake_ticks == 0) return 0;
+
+	latency = (sample_ticks > pm->wake_ticks) ? (uint32_t)(sample_ticks - pm->wake_ticks) : 0;
+	pm->wake_ticks = 0;
+	if(latency < pm->latency_min) pm->latency_min = latency;
+	if(latency > pm->latency_max) pm->latency_max = latency;
+	pm->latency_sum += latency;
+	pm->latency_count++;
+
+	*latency_us = (uint32_t)((uint64_t)latency * 1000000U / pm->tick_hz);
+	return 1;
+}
+
+void tru_adxl345_pm_get_stats(const tru_adxl345_pm_t *pm, uint64_t ticks, tru_adxl345_pm_stats_t *stats){
+	uint64_t asleep = pm->asleep_ticks + (pm->asleep ? ticks - pm->sleep_ticks : 0);
+	uint64_t total = ticks - pm->init_ticks;
+
+	stats->sleeps = pm->sleeps;
+	stats->wakes = pm->wakes;
+	stats->asleep_pct = total ? (uint32_t)(asleep * 100U / total) : 0;
+	stats->latency_min_us = pm->latency_count ? (uint32_t)((uint64_t)pm->latency_min * 1000000U / pm->tick_hz) : 0;
+	stats->latency_max_us = (uint32_t)((uint64_t)pm->latency_max * 1000000U / pm->tick_hz);
+	stats->latency_mean_us = pm->latency_count ? (uint32_t)(pm->latency_sum * 1000000U / pm->tick_hz / pm->latency_count) : 0;
+	// Activity is seen on a sample at the wakeup rate, so the motion may be up
+	// to a wakeup period older than the interrupt
+	stats->detect_max_us = 1000000U / wakeup_hz[pm->wakeup];
+}
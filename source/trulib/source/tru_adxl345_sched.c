@@ -0,0 +1,134 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250130
+
+	Round-robin polling of several ADXL345 sensors, on one or more HPS I2C
+	controllers, with per bus sample throughput.
+*/
+
+#include "tru_adxl345_sched.h"
+#include "tru_cortex_a9.h"
+
+void tru_adxl345_sched_init(tru_adxl345_sched_t *sched, uint32_t tick_hz, tru_adxl345_sched_cb_t callback){
+	sched->count = 0;
+	sched->next = 0;
+	sched->tick_hz = tick_hz;
+	sched->start_ticks = 0;
+	sched->callback = callback;
+}
+
+// Adds a sensor that is already configured for the FIFO stream mode with the
+// given output data rate and watermark.  Returns its index, or -1 when full
+int tru_adxl345_sched_add(tru_adxl345_sched_t *sched, tru_adxl345_dev_t *dev, uint32_t odr_mhz, uint8_t watermark){
+	tru_adxl345_sched_sensor_t *s;
+
+	if(sched->count >= TRU_ADXL345_SCHED_MAX) return -1;
+
+	s = &sched->sensor[sched->count];
+	s->dev = dev;
+	s->watermark = watermark ? watermark : 1;
+	s->samples = 0;
+	s->polls = 0;
+	s->drains = 0;
+	tru_adxl345_ts_init(&s->ts, sched->tick_hz, odr_mhz);
+	tru_adxl345_ts_set_watermark(&s->ts, s->watermark);
+
+	return (int)sched->count++;
+}
+
+// Serves a sensor if it is due.  Returns the number of entries drained.  All
+// the reads for a sensor are done in one go, so sensors sharing a controller
+// cost one IC_TAR switch each (see tru_adxl345_i2c_select())
+static uint32_t tru_adxl345_sched_serve(tru_adxl345_sched_t *sched, uint32_t index){
+	tru_adxl345_sched_sensor_t *s = &sched->sensor[index];
+	tru_adxl345_fifo_status_t fifo_status;
+	tru_adxl345_int_source_t int_source;
+	uint64_t ticks;
+	uint32_t n;
+
+	// No bus access until the watermark is expected to be reached
+	if(gtim_get_counter() < tru_adxl345_ts_poll_time(&s->ts, s->watermark)) return 0;
+
+	// Get current number of sample entries in the FIFO
+	tru_adxl345_i2c_read(s->dev, &fifo_status, 1, TRU_ADXL345_FIFO_STATUS_ADDR);
+	s->polls++;
+	n = fifo_status.bits.entries;
+	if(n < s->watermark) return 0;
+	ticks = gtim_get_counter();
+
+	// Read interrupt triggers, then the samples
+	tru_adxl345_i2c_read(s->dev, &int_source, 1, TRU_ADXL345_INT_SOURCE_ADDR);
+	if(n > TRU_ADXL345_FIFO_DEPTH) n = TRU_ADXL345_FIFO_DEPTH;
+	tru_adxl345_fifo_drain(s->dev, sched->buf, n);
+
+	tru_adxl345_ts_drain(&s->ts, ticks, n, int_source.bits.overrun);
+	s->drains++;
+	if(sched->callback) sched->callback(sched, index, sched->buf, n, int_source);
+	s->samples += n + s->ts.gap;
+
+	return n;
+}
+
+// Runs one round over the sensors.  Returns the number of entries drained
+uint32_t tru_adxl345_sched_poll(tru_adxl345_sched_t *sched){
+	uint32_t n = 0;
+	uint32_t index;
+
+	if(sched->count == 0) return 0;
+	if(sched->start_ticks == 0) sched->start_ticks = gtim_get_counter();
+
+	// Start one sensor further on each round so none always goes first
+	index = sched->next;
+	for(uint32_t i = 0; i < sched->count; i++){
+		n += tru_adxl345_sched_serve(sched, index);
+		index++;
+		if(index >= sched->count) index = 0;
+	}
+	sched->next++;
+	if(sched->next >= sched->count) sched->next = 0;
+
+	return n;
+}
+
+// Totals for the sensors on one controller
+void tru_adxl345_sched_get_bus_stats(const tru_adxl345_sched_t *sched, uint32_t i2c_base, tru_adxl345_sched_bus_stats_t *stats){
+	tru_adxl345_i2c_stats_t i2c_stats;
+	uint64_t ticks = sched->start_ticks ? gtim_get_counter() - sched->start_ticks : 0;
+
+	stats->sensors = 0;
+	stats->samples = 0;
+	stats->polls = 0;
+	for(uint32_t i = 0; i < sched->count; i++){
+		const tru_adxl345_sched_sensor_t *s = &sched->sensor[i];
+
+		if(s->dev->i2c_base != i2c_base) continue;
+		stats->sensors++;
+		stats->samples += s->ts.read;
+		stats->polls += s->polls;
+	}
+	stats->samples_hz = ticks ? (uint32_t)((uint64_t)stats->samples * sched->tick_hz / ticks) : 0;
+
+	tru_adxl345_i2c_get_stats(i2c_base, &i2c_stats);
+	stats->tar_switches = i2c_stats.tar_switches;
+}
@@ -0,0 +1,208 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250211
+
+	ADXL345 self-test: the output change with the DATA_FORMAT self-test bit
+	set, checked against the datasheet limits for the supply voltage and
+	data format, for a go/no-go check at startup.
+*/
+
+#include "tru_adxl345_st.h"
+#include "tru_adxl345_cfg.h"
+#include "tru_cortex_a9.h"
+
+// Datasheet limits of the output change at 2.5V and 256 LSB/g
+static const int32_t st_min_25[3] = { 50, -540, 75 };
+static const int32_t st_max_25[3] = { 540, -50, 875 };
+
+// Datasheet supply scale factors x 100, for the x and y axes and for z
+static const struct{
+	uint32_t vs_mv;
+	uint32_t xy;
+	uint32_t z;
+}st_vs[] = {
+	{ 2000, 64, 80 },
+	{ 2500, 100, 100 },
+	{ 3300, 177, 147 },
+	{ 3600, 211, 169 }
+};
+
+#define ST_VS_ENTRIES (sizeof(st_vs) / sizeof(st_vs[0]))
+
+// Supply scale factor x 100, linear between the entries and clamped outside
+static uint32_t st_vs_factor(uint32_t vs_mv, uint32_t axis){
+	uint32_t i;
+
+	if(vs_mv <= st_vs[0].vs_mv) return axis == 2U ? st_vs[0].z : st_vs[0].xy;
+	for(i = 1; i < ST_VS_ENTRIES - 1U && vs_mv > st_vs[i].vs_mv; i++);
+	if(vs_mv > st_vs[i].vs_mv) vs_mv = st_vs[i].vs_mv;
+
+	uint32_t lo = axis == 2U ? st_vs[i - 1U].z : st_vs[i - 1U].xy;
+	uint32_t hi = axis == 2U ? st_vs[i].z : st_vs[i].xy;
+	return lo + (hi - lo) * (vs_mv - st_vs[i - 1U].vs_mv) / (st_vs[i].vs_mv - st_vs[i - 1U].vs_mv);
+}
+
+// Scales v by factor / 100 and by 2^-shift, rounded to the nearest
+static int32_t st_scale(int32_t v, uint32_t factor, uint32_t shift){
+	int32_t d = (int32_t)(100U << shift);
+	int32_t n = v * (int32_t)factor;
+
+	return n >= 0 ? (n + d / 2) / d : -((-n + d / 2) / d);
+}
+
+// Limits of the output change for a supply voltage and data format.  The force
+// grows with the supply, and at 10 bit the scale is 256 >> range LSB/g
+void tru_adxl345_st_limits(uint32_t vs_mv, tru_adxl345_data_format_t data_format, int32_t *min, int32_t *max){
+	uint32_t shift = data_format.bits.fullres ? 0U : data_format.bits.range;
+
+	for(uint32_t i = 0; i < 3U; i++){
+		uint32_t factor = st_vs_factor(vs_mv, i);
+
+		min[i] = st_scale(st_min_25[i], factor, shift);
+		max[i] = st_scale(st_max_25[i], factor, shift);
+	}
+}
+
+// Sums n samples polled from the data registers, returns 0 on timeout
+static uint8_t st_sum(tru_adxl345_dev_t *dev, uint32_t n, int32_t *sum, uint64_t deadline){
+	tru_adxl345_int_source_t int_source;
+	int16_t xyz[3];
+
+	sum[0] = 0;
+	sum[1] = 0;
+	sum[2] = 0;
+	while(n){
+		if(gtim_get_counter() > deadline) return 0;
+		tru_adxl345_i2c_read(dev, &int_source, 1, TRU_ADXL345_INT_SOURCE_ADDR);
+		if(int_source.bits.dataready){
+			tru_adxl345_i2c_read_bm(dev, xyz, 6, TRU_ADXL345_DATAX0_ADDR);
+			sum[0] += xyz[0];
+			sum[1] += xyz[1];
+			sum[2] += xyz[2];
+			n--;
+		}
+	}
+
+	return 1;
+}
+
+// Rounded mean
+static int32_t st_mean(int32_t sum, uint32_t n){
+	return sum >= 0 ? (sum + (int32_t)n / 2) / (int32_t)n : -((-sum + (int32_t)n / 2) / (int32_t)n);
+}
+
+/*
+	Runs the self-test on a device whose shadow holds its configuration, the
+	configuration is restored afterwards.  The board must be at rest.
+	samples  : averaged with the self-test off and again on, 10 or more
+	vs_mv    : ADXL345 supply voltage VS
+	tick_hz  : global timer frequency
+*/
+void tru_adxl345_st_run(tru_adxl345_dev_t *dev, uint32_t samples, uint32_t vs_mv, uint32_t tick_hz, tru_adxl345_st_result_t *result){
+	tru_adxl345_config_t *shadow = tru_adxl345_shadow(dev);
+	tru_adxl345_config_t saved = *shadow;
+	uint64_t start = gtim_get_counter();
+	uint64_t deadline = start + (uint64_t)tick_hz * TRU_ADXL345_ST_TIMEOUT_MS / 1000U;
+	int32_t sum_off[3];
+	int32_t sum_on[3];
+	uint8_t ok;
+
+	if(samples == 0) samples = 1;
+	result->pass = 0;
+	result->fail = 0;
+	result->samples = samples;
+
+	tru_adxl345_i2c_read(dev, &result->devid, 1, TRU_ADXL345_DEVID_ADDR);
+	if(result->devid != TRU_ADXL345_DEVID) result->fail |= TRU_ADXL345_ST_FAIL_DEVID;
+
+	// Test configuration as the datasheet suggests, measuring without sleep
+	shadow->bw_rate.bits.rate = TRU_ADXL345_RATE_100_HZ;
+	shadow->bw_rate.bits.low_power = 0;
+	shadow->data_format.bits.fullres = 1;
+	shadow->data_format.bits.range = TRU_ADXL345_RANGE_16G;
+	shadow->data_format.bits.selftest = 0;
+	shadow->fifo_ctl.bits.fifomode = TRU_ADXL345_FIFOMODE_BYPASS;
+	shadow->power_ctl.bits.autosleep = 0;
+	shadow->power_ctl.bits.sleep = 0;
+	shadow->power_ctl.bits.measure = 1;
+	tru_adxl345_st_limits(vs_mv, shadow->data_format, result->min, result->max);
+	tru_adxl345_shadow_flush(dev);
+
+	ok = st_sum(dev, TRU_ADXL345_ST_SETTLE, sum_off, deadline) && st_sum(dev, samples, sum_off, deadline);
+	if(ok){
+		shadow->data_format.bits.selftest = 1;
+		tru_adxl345_shadow_flush(dev);
+		ok = st_sum(dev, TRU_ADXL345_ST_SETTLE, sum_on, deadline) && st_sum(dev, samples, sum_on, deadline);
+	}
+
+	*shadow = saved;
+	tru_adxl345_shadow_flush(dev);
+
+	if(ok){
+		for(uint32_t i = 0; i < 3U; i++){
+			result->off[i] = st_mean(sum_off[i], samples);
+			result->on[i] = st_mean(sum_on[i], samples);
+			result->delta[i] = result->on[i] - result->off[i];
+			if(result->delta[i] < result->min[i] || result->delta[i] > result->max[i]) result->fail |= (uint8_t)(TRU_ADXL345_ST_FAIL_X << i);
+		}
+	}else{
+		result->fail |= TRU_ADXL345_ST_FAIL_TIMEOUT;
+		for(uint32_t i = 0; i < 3U; i++){
+			result->off[i] = 0;
+			result->on[i] = 0;
+			result->delta[i] = 0;
+		}
+	}
+
+	result->pass = result->fail == 0;
+	result->time_us = (uint32_t)((gtim_get_counter() - start) * 1000000U / tick_hz);
+}
+
+void tru_adxl345_st_stats_init(tru_adxl345_st_stats_t *stats){
+	stats->runs = 0;
+	stats->passes = 0;
+	stats->timeouts = 0;
+	stats->time_max_us = 0;
+	for(uint32_t i = 0; i < 3U; i++){
+		stats->axis_fails[i] = 0;
+		stats->delta_min[i] = INT32_MAX;
+		stats->delta_max[i] = INT32_MIN;
+	}
+}
+
+// Adds a result to the pass/fail statistics of repeated runs
+void tru_adxl345_st_stats_add(tru_adxl345_st_stats_t *stats, const tru_adxl345_st_result_t *result){
+	stats->runs++;
+	if(result->pass) stats->passes++;
+	if(result->fail & TRU_ADXL345_ST_FAIL_TIMEOUT){
+		stats->timeouts++;
+	}else{
+		for(uint32_t i = 0; i < 3U; i++){
+			if(result->fail & (TRU_ADXL345_ST_FAIL_X << i)) stats->axis_fails[i]++;
+			if(result->delta[i] < stats->delta_min[i]) stats->delta_min[i] = result->delta[i];
+			if(result->delta[i] > stats->delta_max[i]) stats->delta_max[i] = result->delta[i];
+		}
+	}
+	if(result->time_us > stats->time_max_us) stats->time_max_us = result->time_us;
+}
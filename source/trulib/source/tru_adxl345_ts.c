@@ -0,0 +1,186 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250205
+
+	Sample timestamping for the ADXL345 FIFO with an online estimate of the
+	real output data rate, and sample loss accounting.
+*/
+
+#include "tru_adxl345_ts.h"
+
+#define TS_ONE_Q ((uint64_t)1 << TRU_ADXL345_TS_Q)
+
+// Nominal output data rate in mHz for a BW_RATE rate code, 3200Hz / 2^(15 - rate)
+uint32_t tru_adxl345_rate_to_mhz(uint8_t rate){
+	if(rate > 15U) rate = 15U;
+	return 3200000UL >> (15U - rate);
+}
+
+void tru_adxl345_ts_init(tru_adxl345_ts_t *ts, uint32_t tick_hz, uint32_t odr_mhz){
+	if(odr_mhz == 0) odr_mhz = 1;
+
+	ts->tick_hz = tick_hz;
+	ts->nominal_period_q = ((uint64_t)tick_hz * 1000U << TRU_ADXL345_TS_Q) / odr_mhz;
+	ts->period_q = ts->nominal_period_q;
+	ts->newest_q = 0;
+	ts->first_ticks = 0;
+	ts->drains = 0;
+	ts->samples = 0;
+	ts->resid_min = 0;
+	ts->resid_max = 0;
+	ts->resid_abs_sum = 0;
+	ts->resid_count = 0;
+	ts->resyncs = 0;
+	ts->watermark = 1;
+	ts->gap = 0;
+	ts->read = 0;
+	ts->lost = 0;
+	ts->gaps = 0;
+	ts->overruns = 0;
+	ts->late = 0;
+}
+
+// Drains with more entries than this are counted as late
+void tru_adxl345_ts_set_watermark(tru_adxl345_ts_t *ts, uint32_t watermark){
+	ts->watermark = watermark;
+}
+
+static void ts_restart(tru_adxl345_ts_t *ts, uint64_t ticks){
+	ts->newest_q = ticks << TRU_ADXL345_TS_Q;
+	ts->first_ticks = ticks;
+	ts->samples = 0;
+}
+
+// Starts the timeline again from the next drain, for when the samples stopped
+// for a while, e.g. the device slept.  The statistics are kept
+void tru_adxl345_ts_resume(tru_adxl345_ts_t *ts){
+	ts->drains = 0;
+}
+
+/*
+	Adds a drain of n entries whose watermark was seen at timer count ticks,
+	overrun is the INT_SOURCE overrun bit read before the drain.  Returns the
+	corrected time of the newest entry in ticks, use tru_adxl345_ts_sample()
+	for each entry.  ts->gap is set to the number of samples lost right before
+	this drain.
+	The newest entry is taken to be from ticks and the older ones a period
+	apart.  The ADXL345 oscillator can be several percent off, so the period
+	is estimated instead of taken from the rate setting.
+*/
+uint64_t tru_adxl345_ts_drain(tru_adxl345_ts_t *ts, uint64_t ticks, uint32_t n, uint8_t overrun){
+	uint64_t pred_q;
+	int64_t resid_q;
+	int32_t resid;
+
+	ts->gap = 0;
+	if(overrun) ts->overruns++;
+	if(n > ts->watermark) ts->late++;
+	if(n == 0) return ts->newest_q >> TRU_ADXL345_TS_Q;
+	ts->read += n;
+
+	if(ts->drains == 0){
+		ts_restart(ts, ticks);
+		ts->drains++;
+		return ticks;
+	}
+	ts->drains++;
+
+	pred_q = ts->newest_q + ts->period_q * n;
+	resid_q = (int64_t)((ticks << TRU_ADXL345_TS_Q) - pred_q);
+
+	// Samples were discarded, count the whole periods the drain is late by.
+	// The overrun bit means at least one, whatever the timing says.  The
+	// timeline steps over the gap, so the samples after it keep their times
+	if(overrun){
+		if(resid_q > 0) ts->gap = (uint32_t)(((uint64_t)resid_q + ts->period_q / 2U) / ts->period_q);
+		if(ts->gap == 0) ts->gap = 1;
+		ts->lost += ts->gap;
+		ts->gaps++;
+		pred_q += ts->period_q * ts->gap;
+		resid_q -= (int64_t)(ts->period_q * ts->gap);
+	}
+
+	// Too far off to be jitter, start again from the measured time
+	if((uint64_t)(resid_q < 0 ? -resid_q : resid_q) > ts->period_q * n / 2U){
+		ts->resyncs++;
+		ts_restart(ts, ticks);
+		return ticks;
+	}
+
+	ts->samples += n + ts->gap;
+	if(ts->drains <= TRU_ADXL345_TS_LOCK_DRAINS){
+		// Long baseline average
+		ts->period_q = ((ticks - ts->first_ticks) << TRU_ADXL345_TS_Q) / ts->samples;
+		ts->newest_q = ticks << TRU_ADXL345_TS_Q;
+	}else{
+		// Jitter statistics, only once the period is known
+		resid = (int32_t)(resid_q / (int64_t)TS_ONE_Q);
+		if(ts->resid_count == 0 || resid < ts->resid_min) ts->resid_min = resid;
+		if(ts->resid_count == 0 || resid > ts->resid_max) ts->resid_max = resid;
+		ts->resid_abs_sum += (uint32_t)(resid < 0 ? -resid : resid);
+		ts->resid_count++;
+
+		// Alpha-beta tracker: correct the time by a fraction of the residual and
+		// the period by a smaller one per sample.  Arithmetic shift keeps the sign
+		ts->newest_q = pred_q + (uint64_t)(resid_q >> TRU_ADXL345_TS_PHASE_SHIFT);
+		ts->period_q += (uint64_t)((resid_q >> TRU_ADXL345_TS_FREQ_SHIFT) / (int64_t)n);
+	}
+
+	return ts->newest_q >> TRU_ADXL345_TS_Q;
+}
+
+// Time in ticks of entry i (0 = oldest) of the last drain of n entries
+uint64_t tru_adxl345_ts_sample(const tru_adxl345_ts_t *ts, uint32_t n, uint32_t i){
+	return (ts->newest_q - ts->period_q * (n - 1U - i)) >> TRU_ADXL345_TS_Q;
+}
+
+// Time in ticks to start polling for the n-th sample after the newest one
+// read.  Half a period early, plus 1/16 of the span for the rate error before
+// the period is known
+uint64_t tru_adxl345_ts_poll_time(const tru_adxl345_ts_t *ts, uint32_t n){
+	uint64_t span_q = ts->period_q * n;
+
+	return (ts->newest_q + span_q - ts->period_q / 2U - span_q / 16U) >> TRU_ADXL345_TS_Q;
+}
+
+uint64_t tru_adxl345_ts_to_us(const tru_adxl345_ts_t *ts, uint64_t ticks){
+	return (ticks / ts->tick_hz) * 1000000U + (ticks % ts->tick_hz) * 1000000U / ts->tick_hz;
+}
+
+void tru_adxl345_ts_get_stats(const tru_adxl345_ts_t *ts, tru_adxl345_ts_stats_t *stats){
+	uint32_t ticks_per_us = ts->tick_hz / 1000000U;
+
+	if(ticks_per_us == 0) ticks_per_us = 1;
+	stats->odr_mhz = (uint32_t)(((uint64_t)ts->tick_hz * 1000U << TRU_ADXL345_TS_Q) / ts->period_q);
+	stats->drift_ppm = (int32_t)(((int64_t)ts->nominal_period_q - (int64_t)ts->period_q) * 1000000 / (int64_t)ts->period_q);
+	stats->jitter_min_us = ts->resid_min / (int32_t)ticks_per_us;
+	stats->jitter_max_us = ts->resid_max / (int32_t)ticks_per_us;
+	stats->jitter_mean_us = ts->resid_count ? (uint32_t)(ts->resid_abs_sum / ts->resid_count / ticks_per_us) : 0;
+	stats->resyncs = ts->resyncs;
+	stats->read = ts->read;
+	stats->lost = ts->lost;
+	stats->gaps = ts->gaps;
+	stats->overruns = ts->overruns;
+	stats->late = ts->late;
+}
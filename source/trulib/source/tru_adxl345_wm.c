@@ -0,0 +1,126 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250124
+
+	Adaptive FIFO watermark for the ADXL345, picks the number of entries per
+	drain from the output data rate, the measured drain time and the output
+	backlog.
+*/
+
+#include "tru_adxl345_wm.h"
+
+static uint8_t clamp(uint64_t v, uint32_t lo, uint32_t hi){
+	if(v < lo) return (uint8_t)lo;
+	if(v > hi) return (uint8_t)hi;
+	return (uint8_t)v;
+}
+
+// hi keeps the entries that arrive during a drain from overrunning the FIFO,
+// which takes priority over the interrupt rate budget in lo
+static void set_limits(tru_adxl345_wm_t *wm){
+	uint32_t headroom = wm->busy_max / wm->period_ticks + 2U;  // Entries arriving during a drain rounded up, plus one spare
+
+	wm->hi = clamp(TRU_ADXL345_FIFO_DEPTH > headroom ? TRU_ADXL345_FIFO_DEPTH - headroom : 1U, 1U, wm->hi_latency);
+	wm->lo = (wm->lo_irq < wm->hi) ? wm->lo_irq : wm->hi;
+}
+
+/*
+	watermark  : starting watermark
+	latency_us : longest wanted wait of the oldest entry of a batch
+	max_irq_hz : interrupt rate budget, 0 = no budget
+*/
+void tru_adxl345_wm_init(tru_adxl345_wm_t *wm, uint32_t tick_hz, uint32_t odr_mhz, uint8_t watermark, uint32_t latency_us, uint32_t max_irq_hz){
+	if(odr_mhz == 0) odr_mhz = 1;
+
+	wm->tick_hz = tick_hz;
+	wm->odr_mhz = odr_mhz;
+	wm->period_ticks = (uint32_t)((uint64_t)tick_hz * 1000U / odr_mhz);
+	if(wm->period_ticks == 0) wm->period_ticks = 1;
+	wm->lo_irq = max_irq_hz ? clamp(((uint64_t)odr_mhz + max_irq_hz * 1000ULL - 1U) / (max_irq_hz * 1000ULL), 1U, TRU_ADXL345_WM_MAX) : 1U;
+	wm->hi_latency = clamp((uint64_t)latency_us * odr_mhz / 1000000000ULL, 1U, TRU_ADXL345_WM_MAX);
+	wm->calm = 0;
+	wm->busy_max = 0;
+	wm->win_ticks = 0;
+	wm->win_drains = 0;
+	wm->irq_mhz = 0;
+	wm->changes = 0;
+	set_limits(wm);
+	wm->watermark = clamp(watermark, wm->lo, wm->hi);
+}
+
+/*
+	Call after each drain.
+	ticks       : timer count when the watermark was seen
+	n           : entries read
+	busy_ticks  : time from the watermark to the end of the drain, including the output
+	backlog_pct : how full the output path is, 0 to 100
+	Returns the new watermark to program into FIFO_CTL, or 0 if unchanged.
+*/
+uint8_t tru_adxl345_wm_update(tru_adxl345_wm_t *wm, uint64_t ticks, uint32_t n, uint32_t busy_ticks, uint32_t backlog_pct){
+	uint8_t next = wm->watermark;
+
+	// Interrupt rate over windows of about a second
+	if(wm->win_drains == 0){
+		wm->win_ticks = ticks;
+	}else if(ticks - wm->win_ticks >= wm->tick_hz){
+		wm->irq_mhz = (uint32_t)((uint64_t)wm->win_drains * 1000U * wm->tick_hz / (ticks - wm->win_ticks));
+		wm->win_ticks = ticks;
+		wm->win_drains = 0;
+	}
+	wm->win_drains++;
+
+	// Decaying worst drain time sets the headroom
+	wm->busy_max -= wm->busy_max >> TRU_ADXL345_WM_BUSY_DECAY;
+	if(busy_ticks > wm->busy_max) wm->busy_max = busy_ticks;
+	set_limits(wm);
+
+	// A late drain or an output backlog means the consumer is slow, so move more
+	// samples per interrupt.  When calm go back toward lo for the latency
+	if(n > wm->watermark || backlog_pct > TRU_ADXL345_WM_BACKLOG_PCT){
+		wm->calm = 0;
+		next = clamp((uint32_t)wm->watermark * 2U, wm->lo, wm->hi);
+	}else if(++wm->calm >= TRU_ADXL345_WM_CALM_DRAINS){
+		wm->calm = 0;
+		next = clamp(wm->watermark / 2U, wm->lo, wm->hi);
+	}else{
+		next = clamp(wm->watermark, wm->lo, wm->hi);
+	}
+
+	if(next == wm->watermark) return 0;
+	wm->watermark = next;
+	wm->changes++;
+	return next;
+}
+
+void tru_adxl345_wm_get_stats(const tru_adxl345_wm_t *wm, tru_adxl345_wm_stats_t *stats){
+	uint32_t ticks_per_us = wm->tick_hz / 1000000U;
+
+	if(ticks_per_us == 0) ticks_per_us = 1;
+	stats->watermark = wm->watermark;
+	stats->lo = wm->lo;
+	stats->hi = wm->hi;
+	stats->irq_mhz = wm->irq_mhz;
+	stats->busy_us = wm->busy_max / ticks_per_us;
+	stats->changes = wm->changes;
+}
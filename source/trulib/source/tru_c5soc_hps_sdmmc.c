@@ -0,0 +1,83 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250209
+
+	Single block reads and writes on the SD card of the Cyclone V SoC HPS
+	SD/MMC controller, using hwlib's SD/MMC driver.
+*/
+
+#include "tru_config.h"
+
+#if(TRU_TARGET == TRU_C5SOC)
+
+#include "tru_c5soc_hps_sdmmc.h"
+
+// The card is driven by polling the controller FIFO, there is no DMA so the
+// buffers need no cache maintenance, only word alignment.  Block numbers are
+// 512 byte sectors from the start of the card, whatever the card capacity.
+// hwlib takes a 32 bit byte address, so only the first 4 GB can be reached.
+// The card was already used by the preloader to boot, it is identified again
+// here from reset.
+
+static struct{
+	ALT_SDMMC_CARD_INFO_t card;
+	uint8_t ready;
+}tru_hps_sdmmc;
+
+// Resets the controller and identifies the card, 4 bit bus and 512 byte blocks
+ALT_STATUS_CODE tru_hps_sdmmc_init(void){
+	ALT_STATUS_CODE status;
+
+	tru_hps_sdmmc.ready = 0;
+
+	status = alt_sdmmc_init();
+	if(status != ALT_E_SUCCESS) return status;
+	status = alt_sdmmc_card_pwr_on();
+	if(status != ALT_E_SUCCESS) return status;
+	if(!alt_sdmmc_card_is_detected()) return ALT_E_ERROR;
+	status = alt_sdmmc_card_identify(&tru_hps_sdmmc.card);
+	if(status != ALT_E_SUCCESS) return status;
+	status = alt_sdmmc_card_speed_set(&tru_hps_sdmmc.card, tru_hps_sdmmc.card.xfer_speed);
+	if(status != ALT_E_SUCCESS) return status;
+	status = alt_sdmmc_card_bus_width_set(&tru_hps_sdmmc.card, ALT_SDMMC_BUS_WIDTH_4);
+	if(status != ALT_E_SUCCESS) return status;
+	status = alt_sdmmc_card_block_size_set(TRU_HPS_SDMMC_BLOCK_SIZE);
+	if(status != ALT_E_SUCCESS) return status;
+
+	tru_hps_sdmmc.ready = 1;
+	return ALT_E_SUCCESS;
+}
+
+ALT_STATUS_CODE tru_hps_sdmmc_read_block(uint32_t block, uint32_t *buf){
+	if(!tru_hps_sdmmc.ready) return ALT_E_ERROR;
+	return alt_sdmmc_read(&tru_hps_sdmmc.card, buf, (void *)(block * TRU_HPS_SDMMC_BLOCK_SIZE), TRU_HPS_SDMMC_BLOCK_SIZE);
+}
+
+ALT_STATUS_CODE tru_hps_sdmmc_write_block(uint32_t block, const uint32_t *buf){
+	if(!tru_hps_sdmmc.ready) return ALT_E_ERROR;
+	if(alt_sdmmc_card_is_write_protected()) return ALT_E_ERROR;
+	return alt_sdmmc_write(&tru_hps_sdmmc.card, (void *)(block * TRU_HPS_SDMMC_BLOCK_SIZE), (void *)buf, TRU_HPS_SDMMC_BLOCK_SIZE);
+}
+
+#endif
@@ -0,0 +1,151 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250118
+
+	DMA (PL330 DMA-330) transmit for the Cyclone V SoC HPS UART controller,
+	using the UART DMA handshake.
+*/
+
+#include "tru_config.h"
+
+#if(TRU_TARGET == TRU_C5SOC)
+
+#include "tru_c5soc_hps_uart_dma.h"
+#include "alt_16550_uart.h"
+#include "alt_cache.h"
+#include "alt_clock_manager.h"
+#include <string.h>
+
+#if(TRU_HPS_UART_DMA_BUF_SIZE % TRU_HPS_UART_DMA_BUF_ALIGN)
+	#error "TRU_HPS_UART_DMA_BUF_SIZE must be a multiple of TRU_HPS_UART_DMA_BUF_ALIGN"
+#endif
+
+static struct{
+	ALT_16550_HANDLE_t uart;  // Only describes the UART for the DMA program generator, hwlib's UART driver is not used
+	ALT_DMA_CHANNEL_t channel;
+	uint8_t next;             // Index of the buffer being assembled
+	uint8_t busy;
+}tru_hps_uart_dma;
+
+// One program per buffer, a program can't be rebuilt while it runs
+static ALT_DMA_PROGRAM_t tru_hps_uart_dma_pgm[2];
+static uint8_t tru_hps_uart_dma_buf[2][TRU_HPS_UART_DMA_BUF_SIZE] __attribute__((aligned(TRU_HPS_UART_DMA_BUF_ALIGN)));
+
+// Allocates the channel and switches the UART to DMA mode.  The DMA controller
+// must already be initialised with alt_dma_init()
+ALT_STATUS_CODE tru_hps_uart_dma_init(TRU_TARGET_TYPE *uart_base, ALT_DMA_CHANNEL_t channel){
+	ALT_STATUS_CODE status;
+	uint32_t fcr;
+
+	status = alt_dma_channel_alloc(channel);
+	if(status != ALT_E_SUCCESS) return status;
+
+	tru_hps_uart_ll_wait_empty(uart_base);
+
+	// FIFO on, DMA mode 1 so a request bursts while the FIFO is at or below the
+	// quarter full trigger.  FCR is write only, so keep a copy for hwlib
+	fcr = TRU_HPS_UART_FCR_FIFOE_SET_MSK | TRU_HPS_UART_FCR_DMAM_SET_MSK | (TRU_HPS_UART_STET_QUARTER << TRU_HPS_UART_FCR_TET_POS);
+	TRU_HPS_UART_REG(uart_base)->iir_fcr = fcr;
+	TRU_HPS_UART_REG(uart_base)->dmasa = 1U;  // Reset the DMA handshake
+
+	tru_hps_uart_dma.uart.device = ((uintptr_t)uart_base == TRU_HPS_UART0_BASE) ? ALT_16550_DEVICE_SOCFPGA_UART0 : ALT_16550_DEVICE_SOCFPGA_UART1;
+	tru_hps_uart_dma.uart.location = (void *)uart_base;
+	alt_clk_freq_get(ALT_CLK_L4_SP, &tru_hps_uart_dma.uart.clock_freq);
+	tru_hps_uart_dma.uart.data = 0;
+	tru_hps_uart_dma.uart.fcr = fcr;
+	tru_hps_uart_dma.channel = channel;
+	tru_hps_uart_dma.next = 0;
+	tru_hps_uart_dma.busy = 0;
+
+	return ALT_E_SUCCESS;
+}
+
+// Buffer to assemble the next transfer in, TRU_HPS_UART_DMA_BUF_SIZE bytes,
+// while the other one is sent.  It changes after each send
+uint8_t *tru_hps_uart_dma_next_buf(void){
+	return tru_hps_uart_dma_buf[tru_hps_uart_dma.next];
+}
+
+// Polls the channel state, there is no interrupt so this can be called from
+// handlers
+uint8_t tru_hps_uart_dma_busy(void){
+	ALT_DMA_CHANNEL_STATE_t state;
+
+	if(tru_hps_uart_dma.busy){
+		alt_dma_channel_state_get(tru_hps_uart_dma.channel, &state);
+		if(state == ALT_DMA_CHANNEL_STATE_FAULTING){
+			alt_dma_channel_kill(tru_hps_uart_dma.channel);
+			tru_hps_uart_dma.busy = 0;
+		}else if(state == ALT_DMA_CHANNEL_STATE_STOPPED){
+			tru_hps_uart_dma.busy = 0;
+		}
+	}
+
+	return tru_hps_uart_dma.busy;
+}
+
+// Blocking wait until the last transfer has been handed to the UART
+void tru_hps_uart_dma_wait(void){
+	while(tru_hps_uart_dma_busy());
+}
+
+// Send len bytes of buf, which must be the buffer from
+// tru_hps_uart_dma_next_buf().  The other buffer becomes the next one
+ALT_STATUS_CODE tru_hps_uart_dma_send(const uint8_t *buf, uint32_t len){
+	uint8_t i = tru_hps_uart_dma.next;
+	ALT_STATUS_CODE status;
+
+	if(len == 0) return ALT_E_SUCCESS;
+	if(buf != tru_hps_uart_dma_buf[i] || len > TRU_HPS_UART_DMA_BUF_SIZE) return ALT_E_BAD_ARG;
+
+	alt_cache_system_clean(tru_hps_uart_dma_buf[i], (len + TRU_HPS_UART_DMA_BUF_ALIGN - 1U) & ~(TRU_HPS_UART_DMA_BUF_ALIGN - 1U));
+	tru_hps_uart_dma_wait();
+
+	status = alt_dma_memory_to_periph(tru_hps_uart_dma.channel, &tru_hps_uart_dma_pgm[i], (tru_hps_uart_dma.uart.device == ALT_16550_DEVICE_SOCFPGA_UART0) ? ALT_DMA_PERIPH_UART0_TX : ALT_DMA_PERIPH_UART1_TX, tru_hps_uart_dma_buf[i], len, &tru_hps_uart_dma.uart, false, ALT_DMA_EVENT_0);
+	if(status != ALT_E_SUCCESS) return status;
+
+	tru_hps_uart_dma.busy = 1;
+	tru_hps_uart_dma.next = i ^ 1U;
+
+	return ALT_E_SUCCESS;
+}
+
+// Copy and send, for data that is not assembled in place.  It uses up the next
+// buffer, so call tru_hps_uart_dma_next_buf() again before assembling in place
+ALT_STATUS_CODE tru_hps_uart_dma_write(const uint8_t *buf, uint32_t len){
+	ALT_STATUS_CODE status = ALT_E_SUCCESS;
+	uint32_t n;
+
+	while(len && status == ALT_E_SUCCESS){
+		n = (len < TRU_HPS_UART_DMA_BUF_SIZE) ? len : TRU_HPS_UART_DMA_BUF_SIZE;
+		memcpy(tru_hps_uart_dma_next_buf(), buf, n);
+		status = tru_hps_uart_dma_send(tru_hps_uart_dma_next_buf(), n);
+		buf += n;
+		len -= n;
+	}
+
+	return status;
+}
+
+#endif
@@ -30,6 +30,91 @@
 
 #include "tru_c5soc_hps_uart_ll.h"
 
+static void tru_hps_uart_ll_baud_eval(uint32_t clk_freq_hz, uint32_t baud, uint32_t divisor, tru_hps_uart_baud_t *result){
+	uint64_t div16 = (uint64_t)divisor * 16U;
+
+	result->divisor = divisor;
+	result->baud = (uint32_t)(((uint64_t)clk_freq_hz + div16 / 2U) / div16);  // Rounded
+	result->err_ppm = (int32_t)(((int64_t)result->baud - (int64_t)baud) * 1000000 / (int64_t)baud);
+}
+
+/*
+	Finds the divisor giving the rate closest to the requested baud rate for the
+	UART clock (l4_sp_clk).  The closest rate of the two neighbouring divisors is
+	chosen by relative error, not just the rounded divisor.
+*/
+void tru_hps_uart_ll_baud_calc(uint32_t clk_freq_hz, uint32_t baud, tru_hps_uart_baud_t *result){
+	tru_hps_uart_baud_t alt;
+	uint32_t divisor;
+
+	if(baud == 0) baud = 1;
+
+	divisor = (uint32_t)((uint64_t)clk_freq_hz / ((uint64_t)baud * 16U));
+	if(divisor < 1U) divisor = 1U;
+	if(divisor > TRU_HPS_UART_DIVISOR_MAX) divisor = TRU_HPS_UART_DIVISOR_MAX;
+	tru_hps_uart_ll_baud_eval(clk_freq_hz, baud, divisor, result);
+
+	if(divisor < TRU_HPS_UART_DIVISOR_MAX){
+		tru_hps_uart_ll_baud_eval(clk_freq_hz, baud, divisor + 1U, &alt);
+		if((alt.err_ppm < 0 ? -alt.err_ppm : alt.err_ppm) < (result->err_ppm < 0 ? -result->err_ppm : result->err_ppm)) *result = alt;
+	}
+}
+
+/*
+	Waits for USR.BUSY to clear, LCR and the divisor latch can't be written
+	while it is set.  BUSY also stays set while receive data is pending, so
+	pending console input is dropped by resetting the receive FIFO.  A character
+	still arriving gets the rest of the wait to finish.  Returns 0 if the UART
+	is still busy after TRU_HPS_UART_BUSY_TIMEOUT polls, e.g. on continuous
+	receive traffic, else 1
+*/
+static uint8_t tru_hps_uart_ll_wait_idle(TRU_TARGET_TYPE *uart_base){
+	for(uint32_t i = 0U; i < TRU_HPS_UART_BUSY_TIMEOUT; i++){
+		if((TRU_HPS_UART_REG(uart_base)->usr & TRU_HPS_UART_USR_BUSY_SET_MSK) == 0U) return 1;
+		TRU_HPS_UART_REG(uart_base)->srr = TRU_HPS_UART_SRR_RFR_SET_MSK;
+	}
+
+	return 0;
+}
+
+/*
+	Sets the baud rate and the line control (data bits, parity and stop bits,
+	e.g. TRU_HPS_UART_LCR_8N1).  Pending transmit data is sent first at the old
+	rate.  Returns 0 without changing anything if the closest rate is off by more
+	than TRU_HPS_UART_BAUD_MAX_ERR_PPM or the UART stays busy, else 1.  Nothing
+	else may access the UART meanwhile, the interrupt enable register is hidden
+	while the divisor latch is open.
+*/
+uint8_t tru_hps_uart_ll_config(TRU_TARGET_TYPE *uart_base, uint32_t clk_freq_hz, uint32_t baud, uint32_t lcr, tru_hps_uart_baud_t *result){
+	tru_hps_uart_ll_baud_calc(clk_freq_hz, baud, result);
+	if(result->err_ppm > TRU_HPS_UART_BAUD_MAX_ERR_PPM || result->err_ppm < -TRU_HPS_UART_BAUD_MAX_ERR_PPM) return 0;
+
+	tru_hps_uart_ll_wait_empty(uart_base);
+	if(tru_hps_uart_ll_wait_idle(uart_base) == 0) return 0;
+
+	TRU_HPS_UART_REG(uart_base)->lcr = lcr | TRU_HPS_UART_LCR_DLAB_SET_MSK;
+	TRU_HPS_UART_REG(uart_base)->rbr_thr_dll = result->divisor & 0xffU;
+	TRU_HPS_UART_REG(uart_base)->ier_dlh = (result->divisor >> 8) & 0xffU;
+	TRU_HPS_UART_REG(uart_base)->lcr = lcr & ~TRU_HPS_UART_LCR_DLAB_SET_MSK;
+
+	return 1;
+}
+
+// Reads the divisor back from the UART and returns the actual baud rate, or 0
+// if the UART stays busy
+uint32_t tru_hps_uart_ll_baud_readback(TRU_TARGET_TYPE *uart_base, uint32_t clk_freq_hz){
+	uint32_t lcr = TRU_HPS_UART_REG(uart_base)->lcr;
+	uint32_t divisor;
+
+	if(tru_hps_uart_ll_wait_idle(uart_base) == 0) return 0;
+	TRU_HPS_UART_REG(uart_base)->lcr = lcr | TRU_HPS_UART_LCR_DLAB_SET_MSK;
+	divisor = (TRU_HPS_UART_REG(uart_base)->rbr_thr_dll & 0xffU) | ((TRU_HPS_UART_REG(uart_base)->ier_dlh & 0xffU) << 8);
+	TRU_HPS_UART_REG(uart_base)->lcr = lcr;
+
+	if(divisor == 0) return 0;
+	return (uint32_t)(((uint64_t)clk_freq_hz + divisor * 8U) / (divisor * 16U));
+}
+
 /*
 	Blocking wait on the transmit empty register to become empty.  It becomes
 	empty when all pending data in the FIFO (FIFO mode) or holding register
@@ -69,6 +154,19 @@ void tru_hps_uart_ll_write_str(TRU_TARGET_TYPE *uart_base, const char *str, uint
 	}
 }
 
+/*
+	Writes raw bytes without any '\n' to "\r\n" translation, for binary streams.
+*/
+void tru_hps_uart_ll_write_bin(TRU_TARGET_TYPE *uart_base, const uint8_t *buf, uint32_t len){
+	// FIFO & threshold mode enabled?
+	char fifo_th_en = (TRU_HPS_UART_REG(uart_base)->sfe && TRU_HPS_UART_REG(uart_base)->stet) ? 1U : 0U;
+
+	for(uint32_t i = 0U; i < len; i++){
+		tru_hps_uart_ll_wait_ready(uart_base, fifo_th_en);
+		TRU_HPS_UART_REG(uart_base)->rbr_thr_dll = buf[i];
+	}
+}
+
 void tru_hps_uart_ll_write_char(TRU_TARGET_TYPE *uart_base, const char c){
 	// FIFO & threshold mode enabled?
 	char fifo_th_en = (TRU_HPS_UART_REG(uart_base)->sfe && TRU_HPS_UART_REG(uart_base)->stet) ? 1U : 0U;
@@ -0,0 +1,246 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250215
+
+	Interrupt driven transmit ring buffer for the Cyclone V SoC HPS UART
+	controller.
+*/
+
+#include "tru_config.h"
+
+#if(TRU_TARGET == TRU_C5SOC)
+
+#include "tru_c5soc_hps_uart_tx.h"
+#include "RTE_Components.h"   // CMSIS
+#include CMSIS_device_header  // CMSIS
+
+#if(TRU_UART_TX_SIZE & (TRU_UART_TX_SIZE - 1U))
+	#error "TRU_UART_TX_SIZE must be a power of two"
+#endif
+
+#define RING_MSK (TRU_UART_TX_SIZE - 1U)
+#define CPSR_I_MSK 0x80U
+
+static TRU_TARGET_TYPE *uart;
+static uint8_t ring[TRU_UART_TX_SIZE];
+static volatile uint32_t head;  // Free running, masked on access
+static volatile uint32_t tail;
+static tru_hps_uart_tx_stats_t stats;
+
+// Writers may be the main loop and handlers, so the ring is updated with IRQs
+// masked on this CPU
+static uint32_t lock(void){
+	uint32_t cpsr = __get_CPSR();
+
+	__disable_irq();
+	return cpsr;
+}
+
+static void unlock(uint32_t cpsr){
+	if((cpsr & CPSR_I_MSK) == 0U) __enable_irq();
+}
+
+// Move a byte from the ring into the transmit FIFO, returns 0 if either is
+// exhausted
+static uint8_t fill_byte(void){
+	if(head != tail && (TRU_HPS_UART_REG(uart)->usr & TRU_HPS_UART_USR_TFNF_SET_MSK)){
+		TRU_HPS_UART_REG(uart)->rbr_thr_dll = ring[tail & RING_MSK];
+		tail++;
+		return 1;
+	}
+
+	return 0;
+}
+
+// THRE interrupt on while the ring holds data, its handler refills the FIFO
+static void fill_ier(void){
+	if(head == tail){
+		TRU_HPS_UART_REG(uart)->ier_dlh &= ~TRU_HPS_UART_IER_ETBEI_SET_MSK;
+	}else{
+		TRU_HPS_UART_REG(uart)->ier_dlh |= TRU_HPS_UART_IER_ETBEI_SET_MSK;
+	}
+}
+
+// Move bytes from the ring into the transmit FIFO until either is exhausted
+static void fill_fifo(void){
+	while(fill_byte());
+	fill_ier();
+}
+
+// Call with IRQs masked
+static void put(uint8_t c, uint32_t *cpsr){
+	uint32_t used;
+
+	if(head - tail == TRU_UART_TX_SIZE){
+#if(TRU_UART_TX_FULL == TRU_HPS_UART_TX_FULL_DROP)
+		stats.dropped++;
+		return;
+#elif(TRU_UART_TX_FULL == TRU_HPS_UART_TX_FULL_OVERWRITE)
+		tail++;
+		stats.dropped++;
+#else
+		// A writer called with IRQs masked can't wait for the handler, nor can
+		// one the UART interrupt can't preempt under TRU_IRQ_NESTED, so they
+		// feed the FIFO themselves
+		if((*cpsr & CPSR_I_MSK) == 0U){
+			// Let the interrupt handler make space
+			fill_fifo();
+			unlock(*cpsr);
+#if(TRU_IRQ_NESTED == 1U)
+			while(head - tail == TRU_UART_TX_SIZE){
+				*cpsr = lock();
+				fill_fifo();
+				unlock(*cpsr);
+			}
+#else
+			while(head - tail == TRU_UART_TX_SIZE);
+#endif
+			*cpsr = lock();
+		}else{
+			while(head - tail == TRU_UART_TX_SIZE) fill_fifo();
+		}
+#endif
+	}
+
+	ring[head & RING_MSK] = c;
+	head++;
+
+	used = head - tail;
+	if(used > stats.high_water) stats.high_water = used;
+}
+
+/*
+	Takes over transmission for the UART.  Register tru_hps_uart_tx_irq_handler()
+	for the UART interrupt, writes are held in the ring until it is enabled.
+*/
+void tru_hps_uart_tx_init(TRU_TARGET_TYPE *uart_base){
+	tru_hps_uart_ll_wait_empty(uart_base);
+
+	head = 0;
+	tail = 0;
+	stats.dropped = 0;
+	stats.high_water = 0;
+
+	// FIFO on, interrupt when it drains to a quarter full.  With PTIME set
+	// LSR.THRE means FIFO full, which the blocking write functions already expect
+	// when the threshold is set
+	TRU_HPS_UART_REG(uart_base)->sfe = 1U;
+	TRU_HPS_UART_REG(uart_base)->stet = TRU_HPS_UART_STET_QUARTER;
+	TRU_HPS_UART_REG(uart_base)->ier_dlh = (TRU_HPS_UART_REG(uart_base)->ier_dlh & ~TRU_HPS_UART_IER_ETBEI_SET_MSK) | TRU_HPS_UART_IER_PTIME_SET_MSK;
+
+	uart = uart_base;
+}
+
+uint8_t tru_hps_uart_tx_is_init(void){
+	return uart != 0;
+}
+
+// Queue raw bytes
+void tru_hps_uart_tx_write(const uint8_t *buf, uint32_t len){
+	uint32_t cpsr = lock();
+
+	for(uint32_t i = 0; i < len; i++){
+		put(buf[i], &cpsr);
+	}
+	fill_fifo();
+
+	unlock(cpsr);
+}
+
+// Queue text, same as tru_hps_uart_ll_write_str()
+void tru_hps_uart_tx_write_str(const char *str, uint32_t len){
+	uint32_t cpsr = lock();
+
+	for(uint32_t i = 0; i < len; i++){
+		// For each '\n' character insert '\r'?
+		#if defined(TRU_LOG_RN) && TRU_LOG_RN == 1U
+			if(str[i] == '\n') put('\r', &cpsr);
+		#endif
+		put((uint8_t)str[i], &cpsr);
+	}
+	fill_fifo();
+
+	unlock(cpsr);
+}
+
+// Blocking wait until everything queued has been transmitted.  Like put(), it
+// feeds the FIFO itself when the UART interrupt can't run
+void tru_hps_uart_tx_flush(void){
+	uint32_t cpsr;
+
+#if(TRU_IRQ_NESTED == 1U)
+	while(head != tail){
+		cpsr = lock();
+		fill_fifo();
+		unlock(cpsr);
+	}
+#else
+	if((__get_CPSR() & CPSR_I_MSK) == 0U){
+		while(head != tail);
+	}else{
+		while(head != tail){
+			cpsr = lock();
+			fill_fifo();
+			unlock(cpsr);
+		}
+	}
+#endif
+	tru_hps_uart_ll_wait_empty(uart);
+}
+
+// Bytes queued and not yet in the UART FIFO
+uint32_t tru_hps_uart_tx_used(void){
+	return head - tail;
+}
+
+void tru_hps_uart_tx_get_stats(tru_hps_uart_tx_stats_t *s){
+	uint32_t cpsr = lock();
+
+	*s = stats;
+	unlock(cpsr);
+}
+
+void tru_hps_uart_tx_irq_handler(void){
+#if(TRU_IRQ_NESTED == 1U)
+	uint32_t cpsr;
+	uint8_t more;
+#endif
+
+	// Reading IIR clears the THRE interrupt
+	(void)TRU_HPS_UART_REG(uart)->iir_fcr;
+#if(TRU_IRQ_NESTED == 1U)
+	// One byte at a time with IRQs masked, so a writer can preempt between bytes
+	// but not while the tail moves
+	do{
+		cpsr = lock();
+		more = fill_byte();
+		if(!more) fill_ier();
+		unlock(cpsr);
+	}while(more);
+#else
+	fill_fifo();
+#endif
+}
+
+#endif
@@ -0,0 +1,144 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250217
+
+	Deferred work: interrupt handlers post short items that the main loop
+	runs later with interrupts enabled, i.e. top and bottom halves.
+*/
+
+#include "tru_config.h"
+
+#if(TRU_TARGET == TRU_C5SOC)
+
+#include "tru_defer.h"
+#include "tru_cortex_a9.h"
+#include "RTE_Components.h"   // CMSIS
+#include CMSIS_device_header  // CMSIS
+
+#if(TRU_DEFER_SIZE & (TRU_DEFER_SIZE - 1U))
+	#error "TRU_DEFER_SIZE must be a power of two"
+#endif
+
+#define RING_MSK (TRU_DEFER_SIZE - 1U)
+#define CPSR_I_MSK 0x80U
+#define CPSR_F_MSK 0x40U
+
+typedef struct{
+	tru_defer_fn_t fn;
+	uint32_t arg;
+	uint64_t ticks;
+	uint64_t posted_ticks;
+}tru_defer_item_t;
+
+static tru_defer_item_t ring[TRU_DEFER_SIZE];
+static volatile uint32_t head;  // Free running, masked on access
+static volatile uint32_t tail;
+static tru_defer_stats_t stats;
+
+// Posts may come from the main loop, IRQ and FIQ handlers, so both are masked
+static uint32_t IRQ_INT_ONLY(tru_defer_lock) lock(void){
+	uint32_t cpsr = __get_CPSR();
+
+	__ASM volatile("CPSID if" : : : "memory");
+	return cpsr;
+}
+
+static void IRQ_INT_ONLY(tru_defer_unlock) unlock(uint32_t cpsr){
+	if((cpsr & CPSR_F_MSK) == 0U) __ASM volatile("CPSIE f" : : : "memory");
+	if((cpsr & CPSR_I_MSK) == 0U) __enable_irq();
+}
+
+// Queues fn to run from the main loop, from IRQ and FIQ handlers or the main
+// loop.  Returns 0 if the queue is full.  Integer only, for the handlers
+// dispatched without the VFP save
+uint8_t IRQ_INT_ONLY(tru_defer_post) tru_defer_post(tru_defer_fn_t fn, uint32_t arg, uint64_t ticks){
+	uint32_t cpsr = lock();
+	uint32_t used = head - tail;
+	tru_defer_item_t *item;
+
+	if(used >= TRU_DEFER_SIZE){
+		stats.full++;
+		unlock(cpsr);
+		return 0;
+	}
+
+	item = &ring[head & RING_MSK];
+	item->fn = fn;
+	item->arg = arg;
+	item->ticks = ticks;
+	item->posted_ticks = gtim_get_counter();
+	__dmb();
+	head++;
+
+	stats.posted++;
+	if(used + 1U > stats.high_water) stats.high_water = used + 1U;
+	unlock(cpsr);
+
+	return 1;
+}
+
+// Runs the queued items, including any posted meanwhile.  Call from the main
+// loop only.  Returns the number run
+uint32_t tru_defer_run(void){
+	uint32_t n = 0;
+
+	while(tail != head){
+		tru_defer_item_t item = ring[tail & RING_MSK];
+		uint64_t start = gtim_get_counter();
+		uint32_t wait = (uint32_t)(start - item.posted_ticks);
+		uint32_t run;
+
+		__dmb();
+		tail++;
+
+		item.fn(item.arg, item.ticks);
+
+		run = (uint32_t)(gtim_get_counter() - start);
+		if(wait > stats.wait_max_ticks) stats.wait_max_ticks = wait;
+		if(run > stats.run_max_ticks) stats.run_max_ticks = run;
+		stats.run++;
+		n++;
+	}
+
+	return n;
+}
+
+// Sleeps until an interrupt if there is nothing to run.  The check is done
+// masked, and WFI also wakes on a masked IRQ or FIQ, so a post between the
+// check and the WFI isn't missed
+void tru_defer_wait(void){
+	uint32_t cpsr = lock();
+
+	if(tail == head) __WFI();
+	unlock(cpsr);
+}
+
+void tru_defer_get_stats(tru_defer_stats_t *out){
+	uint32_t cpsr = lock();
+
+	*out = stats;
+	unlock(cpsr);
+}
+
+#endif
@@ -29,6 +29,9 @@
 #include "tru_config.h"
 #if defined(TRU_PRINT_UART) && TRU_PRINT_UART == 1U
 	#include "tru_c5soc_hps_uart_ll.h"
+	#if defined(TRU_UART_TX_RING) && TRU_UART_TX_RING == 1U
+		#include "tru_c5soc_hps_uart_tx.h"
+	#endif
 #endif
 #include <errno.h>
 #include <sys/stat.h>
@@ -77,6 +80,13 @@
 		}
 
 		int _write(int fd, char *ptr, int len){
+			#if defined(TRU_UART_TX_RING) && TRU_UART_TX_RING == 1U
+				// Queue to the interrupt driven ring buffer once it is set up
+				if(tru_hps_uart_tx_is_init()){
+					tru_hps_uart_tx_write_str(ptr, len);
+					return len;
+				}
+			#endif
 			tru_hps_uart_ll_write_str((TRU_TARGET_TYPE *)TRU_HPS_UART0_BASE, ptr, len);  // Re-target to UART controller
 			return len;
 		}
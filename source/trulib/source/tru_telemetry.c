@@ -0,0 +1,148 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250114
+
+	Binary telemetry frames for streaming accelerometer samples.
+*/
+
+#include "tru_telemetry.h"
+#include "tru_crc.h"
+
+// COBS encode, returns the encoded length.  The output has no zero bytes and
+// no delimiter, dst must hold TRU_TELEMETRY_COBS_MAX(len) bytes
+uint32_t tru_telemetry_cobs_encode(const uint8_t *src, uint32_t len, uint8_t *dst){
+	uint32_t code_pos = 0;
+	uint32_t out = 1;
+	uint8_t code = 1;
+
+	for(uint32_t i = 0; i < len; i++){
+		if(src[i] == 0){
+			dst[code_pos] = code;
+			code_pos = out++;
+			code = 1;
+		}else{
+			dst[out++] = src[i];
+			code++;
+			if(code == 0xffU){
+				dst[code_pos] = code;
+				code_pos = out++;
+				code = 1;
+			}
+		}
+	}
+	dst[code_pos] = code;
+
+	return out;
+}
+
+static void put_u16(uint8_t *p, uint16_t v){
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v){
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+void tru_telemetry_init(tru_telemetry_t *tm){
+	tm->seq = 0;
+	tm->n = 0;
+	tm->flags = 0;
+	tm->timestamp = 0;
+	tm->frame = tm->frame_buf;
+}
+
+// Flags are sent with the next frame and then cleared
+void tru_telemetry_set_flags(tru_telemetry_t *tm, uint8_t flags){
+	tm->flags |= flags;
+}
+
+// Adds a sample, returns the length of the encoded frame in tm->frame when the
+// frame is full, else 0
+uint32_t tru_telemetry_add(tru_telemetry_t *tm, uint32_t timestamp, int16_t x, int16_t y, int16_t z){
+	uint8_t *p = &tm->raw[TRU_TELEMETRY_HDR_SIZE + tm->n * TRU_TELEMETRY_SAMPLE_SIZE];
+
+	if(tm->n == 0) tm->timestamp = timestamp;
+	put_u16(p, (uint16_t)x);
+	put_u16(p + 2, (uint16_t)y);
+	put_u16(p + 4, (uint16_t)z);
+	tm->n++;
+
+	if(tm->n == TRU_TELEMETRY_SAMPLES) return tru_telemetry_flush(tm);
+	return 0;
+}
+
+// Fills in the header and CRC of the raw frame with len bytes of payload, and
+// encodes it into tm->frame
+static uint32_t encode(tru_telemetry_t *tm, uint8_t n, uint8_t flags, uint32_t timestamp, uint32_t len){
+	uint32_t enc_len;
+
+	put_u16(&tm->raw[0], TRU_TELEMETRY_SYNC);
+	put_u16(&tm->raw[2], tm->seq);
+	put_u32(&tm->raw[4], timestamp);
+	tm->raw[8] = n;
+	tm->raw[9] = flags;
+	len += TRU_TELEMETRY_HDR_SIZE;
+	put_u16(&tm->raw[len], tru_crc16(tm->raw, len));
+	len += TRU_TELEMETRY_CRC_SIZE;
+
+	enc_len = tru_telemetry_cobs_encode(tm->raw, len, tm->frame);
+	tm->frame[enc_len++] = 0;  // Delimiter
+	tm->seq++;
+
+	return enc_len;
+}
+
+// Encodes the samples added so far into tm->frame, returns the encoded length
+// including the delimiter, or 0 if there is nothing to send
+uint32_t tru_telemetry_flush(tru_telemetry_t *tm){
+	uint32_t enc_len;
+
+	if(tm->n == 0) return 0;
+
+	enc_len = encode(tm, tm->n, tm->flags, tm->timestamp, tm->n * TRU_TELEMETRY_SAMPLE_SIZE);
+	tm->n = 0;
+	tm->flags = 0;
+
+	return enc_len;
+}
+
+// Encodes a gap frame for lost samples starting at timestamp into tm->frame,
+// returns the encoded length.  Flush the samples before the gap first, else
+// they are sent after it
+uint32_t tru_telemetry_gap(tru_telemetry_t *tm, uint32_t timestamp, uint32_t lost){
+	uint8_t pending[TRU_TELEMETRY_SAMPLE_SIZE];
+	uint32_t enc_len;
+
+	// The payload shares the raw buffer with the first pending sample
+	for(uint32_t i = 0; i < TRU_TELEMETRY_SAMPLE_SIZE; i++) pending[i] = tm->raw[TRU_TELEMETRY_HDR_SIZE + i];
+	put_u32(&tm->raw[TRU_TELEMETRY_HDR_SIZE], lost);
+	enc_len = encode(tm, 0, TRU_TELEMETRY_FLAG_GAP, timestamp, 4U);
+	for(uint32_t i = 0; i < TRU_TELEMETRY_SAMPLE_SIZE; i++) tm->raw[TRU_TELEMETRY_HDR_SIZE + i] = pending[i];
+
+	return enc_len;
+}
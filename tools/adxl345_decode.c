@@ -0,0 +1,131 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250122
+
+	Host (Linux) decoder for the ADXL345 binary telemetry stream, converts a
+	captured stream to CSV.
+
+	Build:
+		gcc -O2 -I../source/trulib/include -o adxl345_decode adxl345_decode.c ../source/trulib/source/tru_telemetry.c ../source/trulib/source/tru_crc.c
+
+	Usage:
+		stty -F /dev/ttyUSB0 115200 raw
+		cat /dev/ttyUSB0 > capture.bin
+		./adxl345_decode [-a] < capture.bin > samples.csv
+
+	Frames that fail the COBS decode, length or CRC check are counted and
+	skipped, e.g. the start-up text.  Frames flagged as synthetic (benchmark
+	data) are skipped unless -a is given.  A gap frame, samples lost on the
+	target, is written as a row with the lost count in the index column and
+	empty x, y and z.  A summary is printed to stderr.
+*/
+
+#include "tru_telemetry.h"
+#include "tru_crc.h"
+#include <stdio.h>
+#include <string.h>
+
+// Returns the decoded length, or 0 on a malformed frame
+static uint32_t cobs_decode(const uint8_t *src, uint32_t len, uint8_t *dst){
+	uint32_t in = 0;
+	uint32_t out = 0;
+
+	while(in < len){
+		uint8_t code = src[in++];
+
+		if(code == 0 || in + code - 1U > len) return 0;
+		for(uint8_t i = 1; i < code; i++){
+			dst[out++] = src[in++];
+		}
+		if(code != 0xffU && in < len) dst[out++] = 0;
+	}
+
+	return out;
+}
+
+static uint16_t get_u16(const uint8_t *p){
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p){
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int main(int argc, char *argv[]){
+	uint8_t enc[TRU_TELEMETRY_FRAME_MAX];
+	uint8_t raw[TRU_TELEMETRY_FRAME_MAX];
+	uint32_t enc_len = 0;
+	int all = (argc > 1 && strcmp(argv[1], "-a") == 0);
+	unsigned long frames = 0, bad = 0, lost = 0, samples = 0, gaps = 0, lost_samples = 0;
+	uint16_t next_seq = 0;
+	int c;
+
+	printf("seq,timestamp_us,index,x,y,z,flags\n");
+	while((c = getchar()) != EOF){
+		uint32_t len;
+		uint8_t n;
+
+		if(c != 0){
+			// Oversized runs can't be a frame, keep the tail so the count stays right
+			if(enc_len < sizeof(enc)) enc[enc_len] = (uint8_t)c;
+			enc_len++;
+			continue;
+		}
+
+		// Delimiter, decode and check the frame
+		if(enc_len == 0) continue;
+		len = (enc_len <= sizeof(enc)) ? cobs_decode(enc, enc_len, raw) : 0;
+		enc_len = 0;
+		if(len < TRU_TELEMETRY_RAW_SIZE(0) || get_u16(raw) != TRU_TELEMETRY_SYNC){
+			bad++;
+			continue;
+		}
+		n = raw[8];
+		if(len != ((raw[9] & TRU_TELEMETRY_FLAG_GAP) ? TRU_TELEMETRY_GAP_SIZE : TRU_TELEMETRY_RAW_SIZE(n)) || tru_crc16(raw, len - TRU_TELEMETRY_CRC_SIZE) != get_u16(&raw[len - TRU_TELEMETRY_CRC_SIZE])){
+			bad++;
+			continue;
+		}
+		if((raw[9] & TRU_TELEMETRY_FLAG_SYNTHETIC) && !all) continue;
+
+		uint16_t seq = get_u16(&raw[2]);
+		if(frames && seq != next_seq) lost += (uint16_t)(seq - next_seq);
+		next_seq = (uint16_t)(seq + 1U);
+		frames++;
+
+		if(raw[9] & TRU_TELEMETRY_FLAG_GAP){
+			printf("%u,%u,%u,,,,0x%.2x\n", seq, get_u32(&raw[4]), get_u32(&raw[TRU_TELEMETRY_HDR_SIZE]), raw[9]);
+			gaps++;
+			lost_samples += get_u32(&raw[TRU_TELEMETRY_HDR_SIZE]);
+			continue;
+		}
+		for(uint8_t i = 0; i < n; i++){
+			const uint8_t *s = &raw[TRU_TELEMETRY_HDR_SIZE + i * TRU_TELEMETRY_SAMPLE_SIZE];
+			printf("%u,%u,%u,%i,%i,%i,0x%.2x\n", seq, get_u32(&raw[4]), i, (int16_t)get_u16(s), (int16_t)get_u16(s + 2), (int16_t)get_u16(s + 4), raw[9]);
+		}
+		samples += n;
+	}
+
+	fprintf(stderr, "frames=%lu samples=%lu bad=%lu lost=%lu gaps=%lu lost_samples=%lu\n", frames, samples, bad, lost, gaps, lost_samples);
+	return 0;
+}
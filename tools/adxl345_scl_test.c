@@ -0,0 +1,110 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250221
+
+	Host (Linux) test of the I2C SCL count calculation in tru_adxl345_ll.c, for
+	standard and fast mode at several l4_sp clock frequencies.
+
+	Build:
+		gcc -O2 -I../source -I../source/trulib/include -o adxl345_scl_test adxl345_scl_test.c ../source/trulib/source/tru_adxl345_ll.c
+
+	Usage:
+		./adxl345_scl_test
+
+	Prints each failed check and exits with 1 if any failed.  Besides the
+	expected counts, each result is checked against the I2C minimum high and
+	low times.
+*/
+
+#include "tru_adxl345_ll.h"
+#include "tru_c5soc_hps_i2c_ll.h"
+#include <stdio.h>
+
+typedef struct{
+	uint32_t clk_hz;
+	uint32_t speed_hz;
+	uint32_t speed;
+	uint32_t spklen;
+	uint32_t hcnt;
+	uint32_t lcnt;
+	uint32_t scl_hz;
+}scl_case_t;
+
+static const scl_case_t cases[] = {
+	{  50000000U, 100000U, TRU_HPS_I2C_CON_SPEED_100K,  3U, 205U, 234U, 100000U },
+	{  50000000U, 400000U, TRU_HPS_I2C_CON_SPEED_400K,  3U,  15U,  84U, 400000U },
+	{ 100000000U, 100000U, TRU_HPS_I2C_CON_SPEED_100K,  5U, 418U, 469U, 100000U },
+	{ 100000000U, 400000U, TRU_HPS_I2C_CON_SPEED_400K,  5U,  37U, 170U, 400000U },
+	{ 200000000U, 100000U, TRU_HPS_I2C_CON_SPEED_100K, 10U, 843U, 939U, 100000U },
+	{ 200000000U, 400000U, TRU_HPS_I2C_CON_SPEED_400K, 10U,  81U, 341U, 400000U }
+};
+
+static uint32_t fails;
+
+static void check(const scl_case_t *c, const char *name, uint32_t got, uint32_t expect){
+	if(got != expect){
+		printf("FAIL %u Hz clock, %u Hz SCL: %s = %u, expected %u\n", c->clk_hz, c->speed_hz, name, got, expect);
+		fails++;
+	}
+}
+
+// Checks the generated SCL high and low times, in picoseconds, against the minimums
+static void check_min_times(const scl_case_t *c, const tru_adxl345_i2c_scl_t *scl){
+	uint64_t cyc_ps = 1000000000000ULL / c->clk_hz;
+	uint64_t high_ps, low_ps, high_min_ps, low_min_ps;
+
+	if(scl->speed == TRU_HPS_I2C_CON_SPEED_400K){
+		high_ps = (scl->hcnt + scl->spklen + 7U) * cyc_ps + TRU_ADXL345_I2C_FALL_TIME_NS * 1000ULL;
+		low_ps = (scl->lcnt + 1U) * cyc_ps + (TRU_ADXL345_I2C_RISE_TIME_NS - TRU_ADXL345_I2C_FALL_TIME_NS) * 1000ULL;
+		high_min_ps = TRU_ADXL345_I2C_SCL_HIGH_TIME_NS * 1000ULL;
+		low_min_ps = TRU_ADXL345_I2C_SCL_LOW_TIME_NS * 1000ULL;
+	}else{
+		high_ps = (scl->hcnt + scl->spklen + 7U) * cyc_ps + TRU_ADXL345_I2C_SS_FALL_TIME_NS * 1000ULL;
+		low_ps = (scl->lcnt + 1U) * cyc_ps + (TRU_ADXL345_I2C_SS_RISE_TIME_NS - TRU_ADXL345_I2C_SS_FALL_TIME_NS) * 1000ULL;
+		high_min_ps = TRU_ADXL345_I2C_SS_SCL_HIGH_TIME_NS * 1000ULL;
+		low_min_ps = TRU_ADXL345_I2C_SS_SCL_LOW_TIME_NS * 1000ULL;
+	}
+	if(high_ps < high_min_ps) check(c, "high time (ps)", (uint32_t)high_ps, (uint32_t)high_min_ps);
+	if(low_ps < low_min_ps) check(c, "low time (ps)", (uint32_t)low_ps, (uint32_t)low_min_ps);
+}
+
+int main(void){
+	uint32_t n = sizeof(cases) / sizeof(cases[0]);
+
+	for(uint32_t i = 0; i < n; i++){
+		const scl_case_t *c = &cases[i];
+		tru_adxl345_i2c_scl_t scl;
+
+		tru_adxl345_i2c_scl_calc(c->clk_hz, c->speed_hz, &scl);
+		check(c, "speed", scl.speed, c->speed);
+		check(c, "spklen", scl.spklen, c->spklen);
+		check(c, "hcnt", scl.hcnt, c->hcnt);
+		check(c, "lcnt", scl.lcnt, c->lcnt);
+		check(c, "scl freq", tru_adxl345_i2c_scl_freq(c->clk_hz, &scl), c->scl_hz);
+		check_min_times(c, &scl);
+	}
+
+	printf("%u cases, %u failed checks\n", n, fails);
+	return fails ? 1 : 0;
+}
@@ -0,0 +1,151 @@
+/*
+	MIT License
+
+	Copyright (c) 2024 Truong Hy
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+	Version: 20250221
+
+	Host (Linux) test of the UART baud rate divisor calculation in
+	tru_c5soc_hps_uart_ll.c, from 115200 baud to several Mbaud at several l4_sp
+	clock frequencies.
+
+	Build:
+		gcc -O2 -I../source -I../source/trulib/include -o uart_baud_test uart_baud_test.c ../source/trulib/source/tru_c5soc_hps_uart_ll.c
+
+	Usage:
+		./uart_baud_test
+
+	Prints each failed check and exits with 1 if any failed.  The rates off by
+	more than 2.5% must be rejected by tru_hps_uart_ll_config(), which is run
+	on a UART register block in memory.  A UART that stays busy, e.g. receiving,
+	must time out instead of hanging.
+*/
+
+#include "tru_c5soc_hps_uart_ll.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct{
+	uint32_t clk_hz;
+	uint32_t baud;
+	uint32_t divisor;
+	uint32_t actual;
+	int32_t err_ppm;
+	uint8_t accept;
+}baud_case_t;
+
+static const baud_case_t cases[] = {
+	{  50000000U,  115200U,  27U,  115741U,    4696, 1 },
+	{  50000000U,  230400U,  14U,  223214U,  -31189, 0 },
+	{  50000000U,  460800U,   7U,  446429U,  -31187, 0 },
+	{  50000000U,  921600U,   3U, 1041667U,  130281, 0 },
+	{  50000000U, 1000000U,   3U, 1041667U,   41667, 0 },
+	{  50000000U, 1500000U,   2U, 1562500U,   41666, 0 },
+	{  50000000U, 2000000U,   2U, 1562500U, -218750, 0 },
+	{  50000000U, 3125000U,   1U, 3125000U,       0, 1 },
+	{  50000000U, 6250000U,   1U, 3125000U, -500000, 0 },
+	{ 100000000U,  115200U,  54U,  115741U,    4696, 1 },
+	{ 100000000U,  230400U,  27U,  231481U,    4691, 1 },
+	{ 100000000U,  460800U,  14U,  446429U,  -31187, 0 },
+	{ 100000000U,  921600U,   7U,  892857U,  -31188, 0 },
+	{ 100000000U, 1000000U,   6U, 1041667U,   41667, 0 },
+	{ 100000000U, 1500000U,   4U, 1562500U,   41666, 0 },
+	{ 100000000U, 2000000U,   3U, 2083333U,   41666, 0 },
+	{ 100000000U, 3125000U,   2U, 3125000U,       0, 1 },
+	{ 100000000U, 6250000U,   1U, 6250000U,       0, 1 },
+	{ 200000000U,  115200U, 109U,  114679U,   -4522, 1 },
+	{ 200000000U,  230400U,  54U,  231481U,    4691, 1 },
+	{ 200000000U,  460800U,  27U,  462963U,    4694, 1 },
+	{ 200000000U,  921600U,  14U,  892857U,  -31188, 0 },
+	{ 200000000U, 1000000U,  13U,  961538U,  -38462, 0 },
+	{ 200000000U, 1500000U,   8U, 1562500U,   41666, 0 },
+	{ 200000000U, 2000000U,   6U, 2083333U,   41666, 0 },
+	{ 200000000U, 3125000U,   4U, 3125000U,       0, 1 },
+	{ 200000000U, 6250000U,   2U, 6250000U,       0, 1 }
+};
+
+static uint32_t fails;
+
+static void check(const baud_case_t *c, const char *name, int32_t got, int32_t expect){
+	if(got != expect){
+		printf("FAIL %u Hz clock, %u baud: %s = %i, expected %i\n", c->clk_hz, c->baud, name, got, expect);
+		fails++;
+	}
+}
+
+// Runs the configuration on a register block in memory, with the transmitter
+// empty and the UART idle
+static void check_config(const baud_case_t *c){
+	tru_hps_uart_t regs;
+	tru_hps_uart_baud_t result;
+	uint8_t accept;
+
+	memset(&regs, 0, sizeof(regs));
+	regs.lsr = TRU_HPS_UART_LSR_TEMT_SET_MSK;
+	regs.lcr = 0xffU;  // Marks an untouched register
+	accept = tru_hps_uart_ll_config((TRU_TARGET_TYPE *)&regs, c->clk_hz, c->baud, TRU_HPS_UART_LCR_8N1, &result);
+
+	check(c, "accept", accept, c->accept);
+	if(accept){
+		check(c, "lcr", regs.lcr, TRU_HPS_UART_LCR_8N1);
+		check(c, "dll", regs.rbr_thr_dll, c->divisor & 0xffU);
+		check(c, "dlh", regs.ier_dlh, c->divisor >> 8);
+		check(c, "readback", tru_hps_uart_ll_baud_readback((TRU_TARGET_TYPE *)&regs, c->clk_hz), c->actual);
+	}else{
+		check(c, "lcr", regs.lcr, 0xffU);
+		check(c, "dll", regs.rbr_thr_dll, 0);
+	}
+}
+
+// A UART stuck busy must give up without touching LCR, after resetting the
+// receive FIFO
+static void check_busy(const baud_case_t *c){
+	tru_hps_uart_t regs;
+	tru_hps_uart_baud_t result;
+
+	memset(&regs, 0, sizeof(regs));
+	regs.lsr = TRU_HPS_UART_LSR_TEMT_SET_MSK;
+	regs.usr = TRU_HPS_UART_USR_BUSY_SET_MSK;
+	regs.lcr = 0xffU;
+	check(c, "busy accept", tru_hps_uart_ll_config((TRU_TARGET_TYPE *)&regs, c->clk_hz, c->baud, TRU_HPS_UART_LCR_8N1, &result), 0);
+	check(c, "busy lcr", regs.lcr, 0xffU);
+	check(c, "busy srr", regs.srr, TRU_HPS_UART_SRR_RFR_SET_MSK);
+	check(c, "busy readback", tru_hps_uart_ll_baud_readback((TRU_TARGET_TYPE *)&regs, c->clk_hz), 0);
+}
+
+int main(void){
+	uint32_t n = sizeof(cases) / sizeof(cases[0]);
+
+	for(uint32_t i = 0; i < n; i++){
+		const baud_case_t *c = &cases[i];
+		tru_hps_uart_baud_t result;
+
+		tru_hps_uart_ll_baud_calc(c->clk_hz, c->baud, &result);
+		check(c, "divisor", result.divisor, c->divisor);
+		check(c, "baud", result.baud, c->actual);
+		check(c, "err_ppm", result.err_ppm, c->err_ppm);
+		check_config(c);
+	}
+	check_busy(&cases[0]);
+
+	printf("%u cases, %u failed checks\n", n, fails);
+	return fails ? 1 : 0;
+}